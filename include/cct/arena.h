@@ -0,0 +1,363 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARENA_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARENA_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace cct {
+
+/** \brief Chain of free node storage, linked through the storage itself.
+ *
+ * Nodes must be destroyed before they are put into the chain.
+ * Links are copied bytewise, nodes with 32 bit links are not aligned for pointers.
+ */
+template<typename T>
+class NodeFreeList
+{
+    static_assert(sizeof(T) >= sizeof(T *), "node too small for free list");
+
+    T * m_head;
+    T * m_tail;
+
+    static T * next(T * node) noexcept
+    {
+        T * n;
+        std::memcpy(&n, static_cast<void *>(node), sizeof(n));
+        return n;
+    }
+
+    static void setNext(T * node, T * n) noexcept
+    {
+        std::memcpy(static_cast<void *>(node), &n, sizeof(n));
+    }
+public :
+    constexpr NodeFreeList() noexcept
+        : m_head(nullptr), m_tail(nullptr)
+    {}
+
+    bool empty() const noexcept
+    {
+        return !m_head;
+    }
+
+    void push(T * node) noexcept
+    {
+        setNext(node, m_head);
+        if(!m_head)
+            m_tail = node;
+        m_head = node;
+    }
+
+    /** \returns uninitialized storage of a node */
+    T * pop() noexcept
+    {
+        BOOST_ASSERT(m_head);
+        T * node = m_head;
+        m_head = next(node);
+        if(!m_head)
+            m_tail = nullptr;
+        return node;
+    }
+
+    /** \brief Move all nodes of other to this list. O(1) */
+    void splice(NodeFreeList & other) noexcept
+    {
+        if(other.empty())
+            return;
+        setNext(other.m_tail, m_head);
+        if(!m_head)
+            m_tail = other.m_tail;
+        m_head = other.m_head;
+        other.clear();
+    }
+
+    void clear() noexcept
+    {
+        m_head = nullptr;
+        m_tail = nullptr;
+    }
+};
+
+/** \brief Block storage of tree nodes.
+ *
+ * Memory is kept in contiguous blocks of BlockSize nodes,
+ * blocks are handed out to NodeSlab allocators of individual threads.
+ * Single nodes are only returned by NodeSlab, they are reused by slabs before new blocks.
+ * All nodes are dropped at once :
+ *  recycle - all blocks are reused, nodes are dropped without destructors
+ *  release - memory is freed
+ * So nodes must not own anything, apart from links to other nodes of the tree.
+ */
+template<typename T, size_t BlockSize = 1024>
+class NodeArena
+{
+public :
+    typedef T value_type;
+
+    static constexpr size_t block_size = BlockSize;
+private :
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Storage;
+
+    // acquire is called by all threads of a builder
+    boost::mutex m_mutex;
+
+    std::vector<std::unique_ptr<Storage[]>> m_blocks;
+
+    // blocks in use, the rest is free
+    size_t m_used;
+
+    // nodes given back from used blocks
+    NodeFreeList<T> m_free;
+public :
+    NodeArena()
+        : m_used(0)
+    {}
+
+    // arena is noncopyable
+    NodeArena(NodeArena const &) = delete;
+    NodeArena & operator=(NodeArena const &) = delete;
+
+    /** \brief Get uninitialized block of block_size nodes. */
+    T * acquire()
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if(m_used == m_blocks.size())
+        {
+            m_blocks.emplace_back(new Storage[block_size]);
+        }
+        return reinterpret_cast<T *>(m_blocks[m_used++].get());
+    }
+
+    /** \brief Give destroyed nodes back for reuse. O(1) */
+    void deallocate(NodeFreeList<T> & nodes) noexcept
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_free.splice(nodes);
+    }
+
+    /** \brief Take all nodes given back by deallocate. O(1) */
+    void reuse(NodeFreeList<T> & nodes) noexcept
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        nodes.splice(m_free);
+    }
+
+    /** \brief Drop all nodes and keep blocks for reuse. O(1) */
+    void recycle() noexcept
+    {
+        m_used = 0;
+        m_free.clear();
+    }
+
+    /** \brief Drop all nodes and free memory. O(blocks) */
+    void release() noexcept
+    {
+        m_blocks.clear();
+        m_used = 0;
+        m_free.clear();
+    }
+
+    size_t blockCount() const noexcept
+    {
+        return m_blocks.size();
+    }
+
+    size_t usedBlockCount() const noexcept
+    {
+        return m_used;
+    }
+};
+
+/** \brief Block storage of tree nodes in memory of fixed capacity.
+ *
+ * Same interface as NodeArena, but all blocks are taken in order
+ * from one memory block provided by the owner,
+ * so nodes can be linked by 32 bit offsets (see index_node.h).
+ * acquire throws std::bad_alloc when the capacity is exhausted.
+ */
+template<typename T, size_t BlockSize = 1024>
+class FixedNodeArena
+{
+public :
+    typedef T value_type;
+
+    static constexpr size_t block_size = BlockSize;
+private :
+    // acquire is called by all threads of a builder
+    boost::mutex m_mutex;
+
+    T * m_nodes;
+
+    size_t m_block_count;
+
+    // blocks in use, the rest is free
+    size_t m_used;
+
+    // nodes given back from used blocks
+    NodeFreeList<T> m_free;
+public :
+    FixedNodeArena()
+        : m_nodes(nullptr), m_block_count(0), m_used(0)
+    {}
+
+    // arena is noncopyable
+    FixedNodeArena(FixedNodeArena const &) = delete;
+    FixedNodeArena & operator=(FixedNodeArena const &) = delete;
+
+    /** \brief Bytes needed for capacity nodes, rounded up to whole blocks. */
+    static size_t storageSize(size_t capacity) noexcept
+    {
+        return (capacity + block_size - 1)/block_size*block_size*sizeof(T);
+    }
+
+    /** \brief Use memory of storageSize(capacity) bytes, aligned for T. */
+    void init(void * memory, size_t capacity) noexcept
+    {
+        BOOST_ASSERT(reinterpret_cast<std::uintptr_t>(memory) % alignof(T) == 0);
+        m_nodes = static_cast<T *>(memory);
+        m_block_count = (capacity + block_size - 1)/block_size;
+        m_used = 0;
+        m_free.clear();
+    }
+
+    /** \brief Get uninitialized block of block_size nodes. */
+    T * acquire()
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        if(m_used == m_block_count)
+        {
+            throw std::bad_alloc();
+        }
+        return m_nodes + block_size*m_used++;
+    }
+
+    /** \brief Give destroyed nodes back for reuse. O(1) */
+    void deallocate(NodeFreeList<T> & nodes) noexcept
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_free.splice(nodes);
+    }
+
+    /** \brief Take all nodes given back by deallocate. O(1) */
+    void reuse(NodeFreeList<T> & nodes) noexcept
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        nodes.splice(m_free);
+    }
+
+    /** \brief Drop all nodes and keep memory for reuse. O(1) */
+    void recycle() noexcept
+    {
+        m_used = 0;
+        m_free.clear();
+    }
+
+    /** \brief Drop all nodes and forget memory. O(1) */
+    void release() noexcept
+    {
+        m_nodes = nullptr;
+        m_block_count = 0;
+        m_used = 0;
+        m_free.clear();
+    }
+
+    size_t blockCount() const noexcept
+    {
+        return m_block_count;
+    }
+
+    size_t usedBlockCount() const noexcept
+    {
+        return m_used;
+    }
+};
+
+/** \brief Bump allocator of one thread.
+ *
+ * Takes blocks from the arena one by one, so nodes created by one thread
+ * (usually siblings and their parents) are close in memory.
+ * Destroyed nodes are reused first, they go back to the arena with the slab,
+ * together with the unused rest of its block.
+ */
+template<typename Arena>
+class NodeSlab
+{
+    typedef typename Arena::value_type T;
+
+    Arena * m_arena;
+    T * m_next;
+    T * m_end;
+    NodeFreeList<T> m_free;
+public :
+    explicit NodeSlab(Arena & arena) noexcept
+        : m_arena(&arena), m_next(nullptr), m_end(nullptr)
+    {}
+
+    ~NodeSlab() noexcept
+    {
+        for(; m_next != m_end; ++m_next)
+        {
+            m_free.push(m_next);
+        }
+        m_arena->deallocate(m_free);
+    }
+
+    // slab is noncopyable
+    NodeSlab(NodeSlab const &) = delete;
+    NodeSlab & operator=(NodeSlab const &) = delete;
+
+    /** \brief Take over free nodes of other and unused rest of its block, if it is bigger than ours.
+     *
+     * Used when builders are absorbed, so their last blocks are not lost.
+     */
+    void absorb(NodeSlab & other) noexcept
+    {
+        BOOST_ASSERT(m_arena == other.m_arena);
+        if((other.m_end - other.m_next) > (m_end - m_next))
+        {
+            std::swap(m_next, other.m_next);
+            std::swap(m_end, other.m_end);
+        }
+        m_free.splice(other.m_free);
+    }
+
+    template<typename... Args>
+    T * create(Args &&... args)
+    {
+        if(m_free.empty() && (m_next == m_end))
+        {
+            m_arena->reuse(m_free);
+        }
+        if(!m_free.empty())
+        {
+            return new(m_free.pop()) T(std::forward<Args>(args)...);
+        }
+        if(m_next == m_end)
+        {
+            m_next = m_arena->acquire();
+            m_end = m_next + Arena::block_size;
+        }
+        return new(m_next++) T(std::forward<Args>(args)...);
+    }
+
+    /** \brief Destroy node created by any slab of the arena, its storage is reused. */
+    void destroy(T * node) noexcept
+    {
+        node->~T();
+        m_free.push(node);
+    }
+};
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_ARENA_H_INCLUDED
@@ -0,0 +1,250 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_ATTRIBUTES_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_ATTRIBUTES_H_INCLUDED
+
+#include "cct/array_tree.h"
+
+#include "utils/parallel.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace cct {
+
+/** \brief Level of any node, leaves without levels are at 0. */
+template<typename I, typename S, typename L>
+inline L nodeLevel(array_tree<I, S, L> const & tree, S n)
+{
+    BOOST_ASSERT(n < tree.node_count);
+    if(n >= tree.leaf_count)
+        return tree.comp_levels[n-tree.leaf_count];
+    return tree.leaf_levels ? tree.leaf_levels[n] : L(0);
+}
+
+/** \brief Leaf count of every component.
+ *
+ * Children have smaller indices than parents,
+ * so one pass in index order accumulates everything.
+ * O(node_count)
+ */
+template<typename I, typename S, typename L>
+void computeArea(
+    array_tree<I, S, L> const & tree,
+    S * area//[comp_count]
+)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+    I const root = tree.node_capacity - tree.leaf_count;
+    S const lc = tree.leaf_count;
+    std::fill_n(area, tree.node_count-lc, S(0));
+    for(S i = 0; i < lc; ++i)
+    {
+        if(tree.parents[i] != root)
+            ++area[tree.parents[i]];
+    }
+    for(S c = 0; c < tree.node_count-lc; ++c)
+    {
+        if(tree.parents[c+lc] != root)
+            area[tree.parents[c+lc]] += area[c];
+    }
+}
+
+/** \brief Height of every component, leaves are at height 0.
+ *
+ * Children have smaller indices than parents,
+ * so one pass in index order propagates heights up.
+ * O(node_count)
+ * \returns tree height, the maximal number of components above a leaf
+ */
+template<typename I, typename S, typename L>
+S computeHeight(
+    array_tree<I, S, L> const & tree,
+    S * heights//[comp_count]
+)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+    I const root = tree.node_capacity - tree.leaf_count;
+    S const lc = tree.leaf_count;
+    std::fill_n(heights, tree.node_count-lc, S(0));
+    for(S i = 0; i < lc; ++i)
+    {
+        if(tree.parents[i] != root)
+            heights[tree.parents[i]] = 1;
+    }
+    S height = 0;
+    for(S c = 0; c < tree.node_count-lc; ++c)
+    {
+        height = std::max(height, heights[c]);
+        I const p = tree.parents[c+lc];
+        if(p != root)
+            heights[p] = std::max<S>(heights[p], heights[c]+1);
+    }
+    return height;
+}
+
+/** \brief Height of the tree. O(node_count), O(comp_count) memory */
+template<typename I, typename S, typename L>
+S computeHeight(array_tree<I, S, L> const & tree)
+{
+    std::vector<S> heights(tree.node_count-tree.leaf_count);
+    return computeHeight(tree, heights.data());
+}
+
+/** \brief Depth of every node, roots are at depth 0.
+ *
+ * Leaf depth is the number of components above it.
+ * Parents have bigger indices than children,
+ * so one pass in reverse index order propagates depths down.
+ * O(node_count)
+ * \returns tree height
+ */
+template<typename I, typename S, typename L>
+S computeDepth(
+    array_tree<I, S, L> const & tree,
+    S * depths//[node_count]
+)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+    I const root = tree.node_capacity - tree.leaf_count;
+    S const lc = tree.leaf_count;
+    for(S n = tree.node_count; n-- > 0;)
+    {
+        I const p = tree.parents[n];
+        depths[n] = (p != root) ? depths[p+lc]+1 : S(0);
+    }
+    S height = 0;
+    for(S i = 0; i < lc; ++i)
+    {
+        height = std::max(height, depths[i]);
+    }
+    return height;
+}
+
+/** \brief Number of components without parent. O(comp_count) */
+template<typename I, typename S, typename L>
+S countRoots(array_tree<I, S, L> const & tree)
+{
+    I const root = tree.node_capacity - tree.leaf_count;
+    S const lc = tree.leaf_count;
+    return S(std::count(tree.parents+lc, tree.parents+tree.node_count, root));
+}
+
+/** \brief Labels of alpha-connected components at level alpha (alpha cut).
+ *
+ * Leaf gets the region of its topmost ancestor with level <= alpha,
+ * leaves without such ancestor are regions alone. Regions are numbered from 0.
+ * Parents have bigger indices than children,
+ * so one pass in reverse index order labels all components.
+ * O(node_count)
+ * \returns region count
+ */
+template<typename I, typename S, typename L>
+S computeAlphaCut(
+    array_tree<I, S, L> const & tree,
+    L alpha,
+    I * labels//[leaf_count]
+)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+    I const root = tree.node_capacity - tree.leaf_count;
+    I const none = std::numeric_limits<I>::max();
+    S const lc = tree.leaf_count;
+    S const comp_count = tree.node_count-lc;
+    // region of components at or below alpha
+    std::vector<I> regions(comp_count, none);
+    S count = 0;
+    for(S c = comp_count; c-- > 0;)
+    {
+        if(tree.comp_levels[c] > alpha)
+            continue;
+        I const p = tree.parents[c+lc];
+        regions[c] = ((p != root) && (regions[p] != none)) ? regions[p] : I(count++);
+    }
+    for(S i = 0; i < lc; ++i)
+    {
+        I const p = tree.parents[i];
+        labels[i] = ((p != root) && (regions[p] != none)) ? regions[p] : I(count++);
+    }
+    return count;
+}
+
+/** \brief Pattern spectrum (granulometry) in one pass over the tree.
+ *
+ * Every nonroot node n adds
+ *  (level(parent(n)) - level(n)) * area(n)
+ * to spectrum[bin(n, area(n))], it is the volume removed when n is filtered out.
+ * Bins >= bin_count are ignored.
+ * 2D spectra use flat bins, e.g. bin = area_bin*level_bins + level_bin.
+ *
+ * Nodes are split among threads, each accumulates its own histogram.
+ * O(node_count + threads*bin_count)
+ */
+template<
+    typename I, typename S, typename L,
+    typename BinFunction,
+    typename Value
+>
+void patternSpectrum(
+    array_tree<I, S, L> const & tree,
+    S const * area,//[comp_count] from computeArea
+    BinFunction bin,//bin(S node, S area) -> size_t
+    Value * spectrum,//[bin_count]
+    size_t bin_count,
+    unsigned threads = 1
+)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+    I const root = tree.node_capacity - tree.leaf_count;
+    S const lc = tree.leaf_count;
+
+    std::fill_n(spectrum, bin_count, Value(0));
+    boost::mutex mutex;
+    utils::parallelFor(0, tree.node_count, threads,
+        [&](size_t begin, size_t end)
+        {
+            std::vector<Value> histogram(bin_count, Value(0));
+            for(S n = begin; n < end; ++n)
+            {
+                I const p = tree.parents[n];
+                if(p == root)
+                    continue;
+                S const a = (n < lc) ? S(1) : area[n-lc];
+                size_t const b = bin(n, a);
+                if(b < bin_count)
+                {
+                    histogram[b] +=
+                        (Value(tree.comp_levels[p]) - Value(nodeLevel(tree, n))) * Value(a);
+                }
+            }
+            boost::mutex::scoped_lock lock(mutex);
+            for(size_t b = 0; b < bin_count; ++b)
+                spectrum[b] += histogram[b];
+        }
+    );
+}
+
+/** \brief Pattern spectrum with areas computed internally. */
+template<
+    typename I, typename S, typename L,
+    typename BinFunction,
+    typename Value
+>
+void patternSpectrum(
+    array_tree<I, S, L> const & tree,
+    BinFunction bin,//bin(S node, S area) -> size_t
+    Value * spectrum,//[bin_count]
+    size_t bin_count,
+    unsigned threads = 1
+)
+{
+    std::vector<S> area(tree.node_count - tree.leaf_count);
+    computeArea(tree, area.data());
+    patternSpectrum(tree, area.data(), bin, spectrum, bin_count, threads);
+}
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_ATTRIBUTES_H_INCLUDED
@@ -0,0 +1,508 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_BOUNDARY_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_BOUNDARY_H_INCLUDED
+
+#include "cct/array_tree.h"
+#include "cct/image_graph.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+/** \brief Node ids of a tree split into tiles.
+ *
+ * leaves - pixel ids x + y*width of the whole image
+ * components - disjoint ranges of ids, one range per tile tree and one for merges,
+ *  component c of a tile tree with offset o has id o+c
+ */
+typedef uint64_t global_id;
+
+/** \brief Parent of roots. */
+constexpr global_id NO_NODE = std::numeric_limits<global_id>::max();
+
+/** \brief Ancestors of border pixels of an image rectangle.
+ *
+ * Only these components can change, when the rectangle is merged with its neighbours,
+ * so neighbouring tiles can be merged without their full trees.
+ * Size is O(perimeter * height of the tree).
+ */
+template<typename T, typename LevelType>
+struct boundary_tree
+{
+    typedef uint32_t index_type;
+    typedef LevelType level_type;
+
+    /** \brief Parent of roots. */
+    static constexpr index_type none = std::numeric_limits<index_type>::max();
+
+    // image pixels of the tree
+    cv::Rect_<T> rect;
+
+    // pixel ids of border pixels, sorted
+    std::vector<global_id> leaves;
+    // index of the parent component, none if the pixel is alone
+    std::vector<index_type> leaf_parents;//[leaves]
+
+    // ids of components
+    std::vector<global_id> ids;
+    // index of the parent component, none for roots
+    std::vector<index_type> parents;//[ids]
+    std::vector<level_type> levels;//[ids]
+    // all children, including those outside of the boundary tree
+    std::vector<index_type> child_counts;//[ids]
+};
+
+/** \brief Changes of tile trees made by merges of their boundary trees.
+ *
+ * Tile trees on their own are never modified, their nodes get final parents
+ * by correcting tile parents, see correctTile.
+ * Later merges override earlier corrections.
+ */
+template<typename LevelType>
+struct boundary_corrections
+{
+    typedef LevelType level_type;
+
+    // new parents of pixels
+    std::unordered_map<global_id, global_id> leaf_parents;
+    // new parents of components
+    std::unordered_map<global_id, global_id> parents;
+    // removed components, their children belong to the target :
+    //  merged into another component at the same level
+    //  degenerate (one child left), replaced by their parent or NO_NODE
+    std::unordered_map<global_id, global_id> aliases;
+    // components created by merges, their parents are in parents
+    std::vector<std::pair<global_id, level_type>> components;
+
+    /** \brief Component replacing c, or c itself. */
+    global_id resolve(global_id c) const
+    {
+        if(c == NO_NODE)
+            return c;
+        auto i = aliases.find(c);
+        while(i != aliases.end())
+        {
+            c = i->second;
+            i = aliases.find(c);
+        }
+        return c;
+    }
+
+    /** \brief Is component c removed? */
+    bool isAlias(global_id c) const
+    {
+        return aliases.find(c) != aliases.end();
+    }
+
+    /** \brief Final parent of pixel, p is its parent in the tile tree. */
+    global_id leafParent(global_id leaf, global_id p) const
+    {
+        auto i = leaf_parents.find(leaf);
+        return resolve((i == leaf_parents.end()) ? p : i->second);
+    }
+
+    /** \brief Final parent of component, p is its parent in the tile tree. */
+    global_id parent(global_id c, global_id p) const
+    {
+        auto i = parents.find(c);
+        return resolve((i == parents.end()) ? p : i->second);
+    }
+};
+
+namespace image {
+
+template<typename T>
+inline bool isBorderPixel(T x, T y, cv::Rect_<T> const & rect)
+{
+    return (x == rect.x) || (y == rect.y) || (x+1 == rect.x+rect.width) || (y+1 == rect.y+rect.height);
+}
+
+/** \brief Extract boundary tree of a tile tree.
+ *
+ * Leaves of the tile tree are pixels of rect in row-major order.
+ * Components are listed in increasing tile index, so children go before parents.
+ * O(leaf_count of tile)
+ */
+template<
+    typename T,
+    typename I, typename S, typename L
+>
+void exportBoundaryTree(
+    array_tree<I, S, L> const & tree,
+    cv::Rect_<T> const & rect,
+    cv::Size_<T> const & size,// of the whole image
+    global_id comp_offset,
+    boundary_tree<T, L> & out
+)
+{
+    typedef typename boundary_tree<T, L>::index_type index_type;
+    index_type const none = boundary_tree<T, L>::none;
+
+    BOOST_ASSERT(tree.leaf_count == S(rect.width)*S(rect.height));
+    BOOST_ASSERT(tree.invalid_count == 0);
+
+    I const root = tree.node_capacity - tree.leaf_count;
+    // boundary index of components, 0 marks ancestors before numbering
+    std::vector<index_type> index(tree.node_count - tree.leaf_count, none);
+    std::vector<I> local;
+    for(T y = 0; y < rect.height; ++y)
+    {
+        T const step = ((y == 0) || (y+1 == rect.height)) ? 1 : std::max<T>(rect.width-1, 1);
+        for(T x = 0; x < rect.width; x += step)
+        {
+            I const l = I(x + y*rect.width);
+            local.push_back(l);
+            for(I p = tree.parents[l]; (p != root) && (index[p] == none); p = tree.parents[p+tree.leaf_count])
+            {
+                index[p] = 0;
+            }
+        }
+    }
+
+    out.rect = rect;
+    out.ids.clear();
+    out.levels.clear();
+    for(I c = 0; c < index.size(); ++c)
+    {
+        if(index[c] == none)
+            continue;
+        index[c] = index_type(out.ids.size());
+        out.ids.push_back(comp_offset + c);
+        out.levels.push_back(tree.comp_levels[c]);
+    }
+    out.parents.resize(out.ids.size());
+    out.child_counts.assign(out.ids.size(), 0);
+    for(S n = 0; n < tree.node_count; ++n)
+    {
+        I const p = tree.parents[n];
+        if((p != root) && (index[p] != none))
+            ++out.child_counts[index[p]];
+    }
+    for(I c = 0; c < index.size(); ++c)
+    {
+        if(index[c] == none)
+            continue;
+        I const p = tree.parents[c+tree.leaf_count];
+        out.parents[index[c]] = (p == root) ? none : index[p];
+    }
+    out.leaves.resize(local.size());
+    out.leaf_parents.resize(local.size());
+    for(size_t i = 0; i < local.size(); ++i)
+    {
+        I const l = local[i];
+        I const p = tree.parents[l];
+        out.leaves[i] = global_id(rect.y + l/rect.width)*size.width + rect.x + l%rect.width;
+        out.leaf_parents[i] = (p == root) ? none : index[p];
+    }
+}
+
+/** \brief Merge boundary trees of neighbouring rectangles.
+ *
+ * Each edge zips ancestor paths of its pixels, like ThreadBuilder::merge_paths :
+ * components at equal levels are merged, missing ones are created with ids from next_id.
+ * Components left with one child are removed, so the result has no degenerate components.
+ * Edges must contain all pixel pairs between a.rect and b.rect, in any order.
+ * Changed parents, merged and created components are recorded in corrections.
+ * out is the boundary tree of the bounding rectangle of a and b, it must not be a or b.
+ * O((nodes + edges) * height of boundary trees)
+ */
+template<
+    typename T, typename L, typename W
+>
+void mergeBoundaryTrees(
+    cv::Size_<T> const & size,// of the whole image
+    boundary_tree<T, L> const & a,
+    boundary_tree<T, L> const & b,
+    Edge<T, W> const * edges, size_t edge_count,
+    global_id & next_id,
+    boundary_tree<T, L> & out,
+    boundary_corrections<L> & corrections
+)
+{
+    typedef typename boundary_tree<T, L>::index_type index_type;
+    index_type const none = boundary_tree<T, L>::none;
+
+    // nodes : leaves of a, leaves of b, components of a, components of b, new components
+    index_type const leaf_count = index_type(a.leaves.size() + b.leaves.size());
+    index_type const ca = leaf_count;
+    index_type const cb = ca + index_type(a.ids.size());
+    index_type const cn = cb + index_type(b.ids.size());
+
+    std::vector<global_id> ids;
+    std::vector<L> levels;
+    std::vector<index_type> parents;
+    ids.reserve(cn);
+    ids.insert(ids.end(), a.leaves.begin(), a.leaves.end());
+    ids.insert(ids.end(), b.leaves.begin(), b.leaves.end());
+    ids.insert(ids.end(), a.ids.begin(), a.ids.end());
+    ids.insert(ids.end(), b.ids.begin(), b.ids.end());
+    levels.resize(ca);
+    levels.insert(levels.end(), a.levels.begin(), a.levels.end());
+    levels.insert(levels.end(), b.levels.begin(), b.levels.end());
+    std::vector<index_type> counts(ca, 0);
+    counts.insert(counts.end(), a.child_counts.begin(), a.child_counts.end());
+    counts.insert(counts.end(), b.child_counts.begin(), b.child_counts.end());
+    auto shift = [none](index_type p, index_type offset) { return (p == none) ? none : p+offset; };
+    for(index_type p : a.leaf_parents)
+        parents.push_back(shift(p, ca));
+    for(index_type p : b.leaf_parents)
+        parents.push_back(shift(p, cb));
+    for(index_type p : a.parents)
+        parents.push_back(shift(p, ca));
+    for(index_type p : b.parents)
+        parents.push_back(shift(p, cb));
+    std::vector<global_id> original(cn);
+    for(index_type n = 0; n < cn; ++n)
+    {
+        original[n] = (parents[n] == none) ? NO_NODE : ids[parents[n]];
+    }
+    // removed components point to their replacement (or none)
+    std::vector<index_type> alias(cn);
+    for(index_type n = 0; n < cn; ++n)
+        alias[n] = n;
+
+    auto find = [&](index_type n)
+    {
+        while((n != none) && (alias[n] != n))
+        {
+            index_type const m = alias[n];
+            if(m != none)
+                alias[n] = alias[m];
+            n = m;
+        }
+        return n;
+    };
+    auto parent = [&](index_type n)
+    {
+        return find(parents[n]);
+    };
+    // set parent of n, p is a representative
+    auto link = [&](index_type n, index_type p)
+    {
+        index_type const o = parent(n);
+        if(o != none)
+            --counts[o];
+        parents[n] = p;
+        if(p != none)
+            ++counts[p];
+    };
+    // merge component n into p at the same level
+    auto merge = [&](index_type n, index_type p)
+    {
+        index_type const o = parent(n);
+        if(o != none)
+            --counts[o];
+        counts[p] += counts[n];
+        alias[n] = p;
+    };
+    auto leaf = [&](global_id id)
+    {
+        auto i = std::lower_bound(a.leaves.begin(), a.leaves.end(), id);
+        if((i != a.leaves.end()) && (*i == id))
+            return index_type(i - a.leaves.begin());
+        auto j = std::lower_bound(b.leaves.begin(), b.leaves.end(), id);
+        BOOST_ASSERT((j != b.leaves.end()) && (*j == id));
+        return index_type(a.leaves.size() + (j - b.leaves.begin()));
+    };
+    // highest ancestor of leaf at most at level w
+    auto climb = [&](index_type n, W const & w)
+    {
+        for(index_type p = parent(n); (p != none) && !(w < levels[p]); p = parent(p))
+            n = p;
+        return n;
+    };
+    auto isComponentAt = [&](index_type n, W const & w)
+    {
+        return (n >= leaf_count) && !(levels[n] < w) && !(w < levels[n]);
+    };
+
+    for(size_t i = 0; i < edge_count; ++i)
+    {
+        W const & w = edges[i].weight;
+        index_type x = climb(leaf(global_id(pointId(edges[i].points[0], size))), w);
+        index_type y = climb(leaf(global_id(pointId(edges[i].points[1], size))), w);
+        if(x == y)
+            continue;
+        index_type px = parent(x);
+        index_type py = parent(y);
+        index_type n;
+        if(isComponentAt(x, w))
+        {
+            n = x;
+            if(isComponentAt(y, w))
+                merge(y, x);
+            else
+                link(y, x);
+        }
+        else if(isComponentAt(y, w))
+        {
+            n = y;
+            link(x, y);
+        }
+        else
+        {
+            n = index_type(ids.size());
+            ids.push_back(next_id++);
+            levels.push_back(w);
+            parents.push_back(none);
+            counts.push_back(0);
+            alias.push_back(n);
+            link(x, n);
+            link(y, n);
+        }
+        // zip both paths above n
+        while(px != py)
+        {
+            if(py == none || ((px != none) && (levels[px] < levels[py])))
+            {
+                link(n, px);
+                n = px;
+                px = parent(px);
+            }
+            else if(px == none || (levels[py] < levels[px]))
+            {
+                link(n, py);
+                n = py;
+                py = parent(py);
+            }
+            else
+            {
+                index_type const qx = parent(px);
+                index_type const qy = parent(py);
+                merge(py, px);
+                link(n, px);
+                n = px;
+                px = qx;
+                py = qy;
+            }
+        }
+        link(n, px);
+    }
+    // components, which lost children to their siblings, are replaced by their parent
+    for(index_type n = leaf_count; n < ids.size(); ++n)
+    {
+        if((find(n) == n) && (counts[n] == 1))
+            alias[n] = parent(n);
+    }
+
+    // record changes
+    for(index_type n = 0; n < ids.size(); ++n)
+    {
+        index_type const r = find(n);
+        if(r != n)
+        {
+            corrections.aliases[ids[n]] = (r == none) ? NO_NODE : ids[r];
+            continue;
+        }
+        index_type const p = parent(n);
+        global_id const pid = (p == none) ? NO_NODE : ids[p];
+        if(n >= cn)
+        {
+            corrections.components.push_back(std::make_pair(ids[n], levels[n]));
+            corrections.parents[ids[n]] = pid;
+        }
+        else if(pid != original[n])
+        {
+            if(n < leaf_count)
+                corrections.leaf_parents[ids[n]] = pid;
+            else
+                corrections.parents[ids[n]] = pid;
+        }
+    }
+
+    // boundary tree of the union
+    cv::Rect_<T> const rect = a.rect | b.rect;
+    std::vector<index_type> index(ids.size(), none);
+    std::vector<index_type> kept;
+    for(index_type n = 0; n < leaf_count; ++n)
+    {
+        global_id const id = ids[n];
+        if(!isBorderPixel(T(id % size.width), T(id / size.width), rect))
+            continue;
+        kept.push_back(n);
+        for(index_type p = parent(n); (p != none) && (index[p] == none); p = parent(p))
+        {
+            index[p] = 0;
+        }
+    }
+    std::sort(kept.begin(), kept.end(), [&](index_type u, index_type v) { return ids[u] < ids[v]; });
+
+    out.rect = rect;
+    out.ids.clear();
+    out.levels.clear();
+    for(index_type n = leaf_count; n < ids.size(); ++n)
+    {
+        if(index[n] == none)
+            continue;
+        index[n] = index_type(out.ids.size());
+        out.ids.push_back(ids[n]);
+        out.levels.push_back(levels[n]);
+    }
+    out.parents.resize(out.ids.size());
+    out.child_counts.resize(out.ids.size());
+    for(index_type n = leaf_count; n < ids.size(); ++n)
+    {
+        if(index[n] == none)
+            continue;
+        index_type const p = parent(n);
+        out.parents[index[n]] = (p == none) ? none : index[p];
+        out.child_counts[index[n]] = counts[n];
+    }
+    out.leaves.resize(kept.size());
+    out.leaf_parents.resize(kept.size());
+    for(size_t i = 0; i < kept.size(); ++i)
+    {
+        index_type const p = parent(kept[i]);
+        out.leaves[i] = ids[kept[i]];
+        out.leaf_parents[i] = (p == none) ? none : index[p];
+    }
+}
+
+/** \brief Final parents of tile nodes, after all boundary merges.
+ *
+ * parents[node_count of tile] - leaves, then components of the tile,
+ * NO_NODE for roots. Removed components keep NO_NODE,
+ * corrections.isAlias tells them apart.
+ * O(node_count of tile)
+ */
+template<
+    typename T,
+    typename I, typename S, typename L
+>
+void correctTile(
+    array_tree<I, S, L> const & tree,
+    cv::Rect_<T> const & rect,
+    cv::Size_<T> const & size,// of the whole image
+    global_id comp_offset,
+    boundary_corrections<L> const & corrections,
+    global_id * parents//[tree.node_count]
+)
+{
+    BOOST_ASSERT(tree.leaf_count == S(rect.width)*S(rect.height));
+
+    I const root = tree.node_capacity - tree.leaf_count;
+    auto id = [&](I p) { return (p == root) ? NO_NODE : comp_offset + p; };
+    for(S l = 0; l < tree.leaf_count; ++l)
+    {
+        global_id const leaf = global_id(rect.y + l/rect.width)*size.width + rect.x + l%rect.width;
+        parents[l] = corrections.leafParent(leaf, id(tree.parents[l]));
+    }
+    for(S n = tree.leaf_count; n < tree.node_count; ++n)
+    {
+        global_id const c = comp_offset + (n - tree.leaf_count);
+        parents[n] = corrections.isAlias(c) ? NO_NODE : corrections.parent(c, id(tree.parents[n]));
+    }
+}
+
+}//namespace image
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_BOUNDARY_H_INCLUDED
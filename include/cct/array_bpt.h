@@ -0,0 +1,96 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_BPT_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_BPT_H_INCLUDED
+
+#include "cct/array_tree.h"
+
+#include "utils/parallel.h"
+
+#include <boost/assert.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace cct {
+
+/** \brief Parallel variant of array_tree::bpt_postprocess.
+ *
+ * Collapses chains of equal-level components of a binary partition tree,
+ * the result (after compress) is the same as with the serial version.
+ *
+ * reps[c] is the topmost component of the equal-level chain containing c :
+ *  1. each chunk of components links to equal-level parents
+ *     and resolves links inside of the chunk (top-down)
+ *  2. nodes chase the links across chunks (read only) and get new parents,
+ *     collapsed components are invalidated
+ * O(node_count/threads + chunk_count) per thread
+ *
+ * Call compress() afterwards, reps can be used as its lut.
+ */
+template<typename I, typename S, typename L>
+void bptPostprocess(
+    array_tree<I, S, L> & tree,
+    I * reps,//[comp_count]
+    unsigned threads = 1
+)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+    I const root = tree.node_capacity - tree.leaf_count;
+    S const lc = tree.leaf_count;
+    S const comp_count = tree.node_count - lc;
+    I const * parents = tree.parents;
+    L const * levels = tree.comp_levels;
+
+    // chunk-local representatives
+    utils::parallelFor(0, comp_count, threads,
+        [&](size_t begin, size_t end)
+        {
+            for(S c = end; c-- > begin;)
+            {
+                I const p = parents[c+lc];
+                if((p != root) && (levels[p] == levels[c]))
+                {
+                    // parent is already resolved, if it is in this chunk
+                    reps[c] = (p < end) ? reps[p] : p;
+                }
+                else
+                {
+                    reps[c] = c;
+                }
+            }
+        }
+    );
+
+    auto find = [reps](I c) -> I
+        {
+            while(reps[c] != c)
+                c = reps[c];
+            return c;
+        };
+
+    // new parents
+    S invalid_count = 0;
+    boost::mutex mutex;
+    utils::parallelFor(0, tree.node_count, threads,
+        [&](size_t begin, size_t end)
+        {
+            S invalid = 0;
+            for(S n = begin; n < end; ++n)
+            {
+                if((n >= lc) && (find(n-lc) != n-lc))
+                {
+                    tree.parents[n] = 0;
+                    ++invalid;
+                }
+                else if(tree.parents[n] != root)
+                {
+                    tree.parents[n] = find(tree.parents[n]);
+                }
+            }
+            boost::mutex::scoped_lock lock(mutex);
+            invalid_count += invalid;
+        }
+    );
+    tree.invalid_count += invalid_count;
+}
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_BPT_H_INCLUDED
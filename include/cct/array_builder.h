@@ -2,13 +2,58 @@
 #define CONNECTED_COMPONENT_TREE_ARRAY_TREE_BUILDER_H_INCLUDED
 
 #include "cct/image_graph.h"
+#include "cct/array_storage.h"
 #include "cct/array_tree.h"
 #include "cct/root_finder.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 namespace cct {
 
 namespace image {
 
+/** \brief Kruskal-like alpha-tree construction from sorted edges.
+ *
+ * root must contain leaf_count singletons with data = leaf index.
+ */
+template<
+    typename T, typename I, typename S, typename Weight
+>
+void buildAlphaTree(
+    cv::Size_<T> const & size,
+    Edge<T, Weight> const * edges, size_t edge_count,
+    array_tree<I, S, Weight> & tree,
+    cct::PackedRootFinder<S, I> & root,
+    I * merges//[max(leaf_count, node_capacity-leaf_count+1)]
+)
+{
+    if(edge_count == 0)
+        return;
+
+    Weight weight = edges[0].weight;
+    S layer_begin = tree.node_count;
+    for(size_t i = 0; i < edge_count; ++i)
+    {
+        if(edges[i].weight > weight)
+        {
+            weight = edges[i].weight;
+            layer_begin = tree.node_count;
+        }
+        I const ha = root.find_update(pointId<I>(edges[i].points[0], size));
+        I const hb = root.find_update(pointId<I>(edges[i].points[1], size));
+        if(ha != hb)
+        {
+            root.merge_set(ha, hb,
+                tree.alpha_merge(root.data(ha), root.data(hb), layer_begin, edges[i].weight, merges)
+            );
+        }
+    }
+    tree.finish_alpha_merges(merges);
+    tree.compress(merges);
+}
+
 template<
     typename T, typename I, typename S, typename Weight,
     typename EdgeWeightFunction
@@ -28,33 +73,131 @@ void buildAlphaTree(
 
     std::vector<Edge> edges(edgeCount<size_t>(size));
     size_t const edge_count = getSortedImageEdges(
-        Rect(0, 0, size.width, size.height), tile, &edges[0], e);
+        Rect(0, 0, size.width, size.height), tile, edges.data(), e);
 
     cct::PackedRootFinder<S, I> root(vertexCount<I>(size), cct::LeafIndexTag());
     
-    std::unique_ptr<S[]> merges(new S[tree.leaf_count]);
+    std::unique_ptr<I[]> merges(new I[std::max<size_t>(tree.leaf_count, tree.node_capacity-tree.leaf_count+1)]);
 
-    Weight weight = edges[0].weight;
-    S layer_begin = tree.node_count;
-    for(size_t i = 0; i < edge_count; ++i)
+    buildAlphaTree(size, edges.data(), edge_count, tree, root, merges.get());
+} 
+
+/** \brief Build alpha-tree into reusable storage.
+ *
+ * Tree is initialized for the image size, edges, merges and root finder
+ * use memory of the storage, so no allocation happens once it is big enough.
+ */
+template<
+    typename T, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction
+>
+array_tree<I, S, Weight> & buildAlphaTree(
+    cv::Size_<T> const & size, cv::Size_<T> const & tile,
+    array_tree_storage<I, S, Weight> & storage,
+    EdgeWeightFunction e
+)
+{
+    typedef cv::Rect_<T> Rect;
+
+    typedef Edge<T, Weight> Edge;
+
+    S const leaf_count = S(size.width)*S(size.height);
+    array_tree<I, S, Weight> & tree = storage.init(leaf_count);
+
+    Edge * edges = storage.template buffer<Edge>(edgeCount<size_t>(size));
+    size_t const edge_count = getSortedImageEdges(
+        Rect(0, 0, size.width, size.height), tile, edges, e);
+
+    storage.root_finder().init(leaf_count, cct::LeafIndexTag());
+
+    buildAlphaTree(size, edges, edge_count, tree, storage.root_finder(), storage.merges());
+    return tree;
+}
+
+/** \brief Second-order tree construction for array_tree.
+ *
+ * Vertex weights are stored in leaf_levels, so the vertex stream needs no sorting
+ * and edges are processed as for the alpha-tree.
+ *
+ * REQUIRES :
+ *  tree.leaf_levels != nullptr
+ *  edge weight >= weights of both its vertices
+ */
+template<
+    typename T, typename I, typename S, typename Weight,
+    typename VertexWeightFunction,
+    typename EdgeWeightFunction
+>
+void buildSecondOrderTree(
+    cv::Size_<T> const & size, cv::Size_<T> const & tile,
+    array_tree<I, S, Weight> & tree,
+    VertexWeightFunction v,
+    EdgeWeightFunction e
+)
+{
+    typedef cv::Point_<T> Point;
+    typedef cv::Rect_<T> Rect;
+
+    typedef Edge<T, Weight> Edge;
+
+    BOOST_ASSERT(tree.leaf_levels);
+    for(T y = 0; y < size.height; ++y)
     {
-        if(edges[i].weight > weight)
+        for(T x = 0; x < size.width; ++x)
         {
-            weight = edges[i].weight;
-            layer_begin = tree.node_count;
+            tree.leaf_levels[pointId<I>(Point(x, y), size)] = v(Point(x, y));
         }
-        I const ha = root.find_update(pointId<I>(edges[i].points[0], size));
-        I const hb = root.find_update(pointId<I>(edges[i].points[1], size));
-        if(ha != hb)
+    }
+
+    std::vector<Edge> edges(edgeCount<size_t>(size));
+    size_t const edge_count = getSortedImageEdges(
+        Rect(0, 0, size.width, size.height), tile, edges.data(), e);
+
+    cct::PackedRootFinder<S, I> root(vertexCount<I>(size), cct::LeafIndexTag());
+
+    std::unique_ptr<I[]> merges(new I[std::max<size_t>(tree.leaf_count, tree.node_capacity-tree.leaf_count+1)]);
+
+    buildAlphaTree(size, edges.data(), edge_count, tree, root, merges.get());
+}
+
+/** \brief Second-order tree construction into reusable storage. */
+template<
+    typename T, typename I, typename S, typename Weight,
+    typename VertexWeightFunction,
+    typename EdgeWeightFunction
+>
+array_tree<I, S, Weight> & buildSecondOrderTree(
+    cv::Size_<T> const & size, cv::Size_<T> const & tile,
+    array_tree_storage<I, S, Weight> & storage,
+    VertexWeightFunction v,
+    EdgeWeightFunction e
+)
+{
+    typedef cv::Point_<T> Point;
+    typedef cv::Rect_<T> Rect;
+
+    typedef Edge<T, Weight> Edge;
+
+    S const leaf_count = S(size.width)*S(size.height);
+    array_tree<I, S, Weight> & tree = storage.init(leaf_count);
+
+    for(T y = 0; y < size.height; ++y)
+    {
+        for(T x = 0; x < size.width; ++x)
         {
-            root.merge_set(ha, hb,
-                tree.alpha_merge(root.data(ha), root.data(hb), layer_begin, edges[i].weight, merges.get())
-            );
+            tree.leaf_levels[pointId<I>(Point(x, y), size)] = v(Point(x, y));
         }
     }
-    tree.finish_alpha_merges(merges.get());
-    tree.compress(merges.get());
-} 
+
+    Edge * edges = storage.template buffer<Edge>(edgeCount<size_t>(size));
+    size_t const edge_count = getSortedImageEdges(
+        Rect(0, 0, size.width, size.height), tile, edges, e);
+
+    storage.root_finder().init(leaf_count, cct::LeafIndexTag());
+
+    buildAlphaTree(size, edges, edge_count, tree, storage.root_finder(), storage.merges());
+    return tree;
+}
 
 }//namespace image
 
@@ -0,0 +1,69 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_EXPORT_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_EXPORT_H_INCLUDED
+
+#include "cct/array_tree.h"
+#include "cct/tree.h"
+
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+/** \brief Convert pointer tree to array_tree.
+ *
+ * Components are numbered in post-order, so parents[i]+lc > i holds.
+ * O(node_count)
+ *
+ * REQUIRES :
+ *  out.leaf_count == tree.leafCount()
+ *  out.node_capacity >= tree.nodeCount()
+ */
+template<
+    typename Component, typename Leaf,
+    typename IndexType, typename SizeType, typename LevelType
+>
+void exportTree(
+    Tree<Component, Leaf> const & tree,
+    array_tree<IndexType, SizeType, LevelType> & out
+)
+{
+    typedef SizeType size_type;
+    typedef IndexType index_type;
+
+    BOOST_ASSERT(out.leaf_count == tree.leafCount());
+    BOOST_ASSERT(out.node_capacity >= tree.nodeCount());
+
+    out.reset();
+    index_type const root = out.node_capacity - out.leaf_count;
+    // nodes waiting for their parent to be numbered
+    std::vector<size_type> pending;
+    // beginnings of child lists of open components in pending
+    std::vector<size_t> marks;
+    tree.forEach(
+        [&](Component const &)
+        {
+            marks.push_back(pending.size());
+        },
+        [&](Component const & c)
+        {
+            size_type const n = out.node_count++;
+            index_type const ci = n - out.leaf_count;
+            out.comp_levels[ci] = c.level();
+            out.parents[n] = root;
+            for(size_t i = marks.back(); i < pending.size(); ++i)
+                out.parents[pending[i]] = ci;
+            pending.resize(marks.back());
+            marks.pop_back();
+            pending.push_back(n);
+        },
+        [&](Leaf const & l)
+        {
+            pending.push_back(tree.leafId(l));
+        }
+    );
+}
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_EXPORT_H_INCLUDED
@@ -0,0 +1,99 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_IO_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_IO_H_INCLUDED
+
+#include "cct/array_storage.h"
+#include "cct/array_tree.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+/** \brief Binary format of array_tree.
+ *
+ * Native byte order, no padding :
+ *  magic "CCTA"
+ *  uint8 sizeof(index_type), sizeof(size_type), sizeof(level_type), has leaf levels
+ *  uint64 leaf_count, node_count, node_capacity
+ *  parents[node_count]
+ *  leaf_levels[leaf_count] - only if present
+ *  comp_levels[node_count-leaf_count]
+ * Children are not stored, see array_tree::build_children.
+ */
+struct array_tree_header
+{
+    char magic[4];
+    uint8_t index_size;
+    uint8_t size_size;
+    uint8_t level_size;
+    uint8_t leaf_levels;
+    uint64_t leaf_count;
+    uint64_t node_count;
+    uint64_t node_capacity;
+};
+
+/** \brief Write compressed tree (invalid_count == 0) to a binary stream.
+ * \throws std::runtime_error on write errors
+ */
+template<typename I, typename S, typename L>
+void writeTree(std::ostream & o, array_tree<I, S, L> const & tree)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+
+    array_tree_header h;
+    std::memcpy(h.magic, "CCTA", 4);
+    h.index_size = sizeof(I);
+    h.size_size = sizeof(S);
+    h.level_size = sizeof(L);
+    h.leaf_levels = (tree.leaf_levels != nullptr);
+    h.leaf_count = tree.leaf_count;
+    h.node_count = tree.node_count;
+    h.node_capacity = tree.node_capacity;
+    o.write(reinterpret_cast<char const *>(&h), sizeof(h));
+    o.write(reinterpret_cast<char const *>(tree.parents), tree.node_count*sizeof(I));
+    if(tree.leaf_levels)
+        o.write(reinterpret_cast<char const *>(tree.leaf_levels), tree.leaf_count*sizeof(L));
+    o.write(reinterpret_cast<char const *>(tree.comp_levels), (tree.node_count-tree.leaf_count)*sizeof(L));
+    if(!o)
+        throw std::runtime_error("array_tree write failed");
+}
+
+/** \brief Read tree written by writeTree into storage.
+ * \throws std::runtime_error on read errors, on different types and on invalid counts
+ */
+template<typename I, typename S, typename L>
+array_tree<I, S, L> & readTree(std::istream & in, array_tree_storage<I, S, L> & storage)
+{
+    array_tree_header h;
+    in.read(reinterpret_cast<char *>(&h), sizeof(h));
+    if(!in || std::memcmp(h.magic, "CCTA", 4))
+        throw std::runtime_error("not an array_tree");
+    if((h.index_size != sizeof(I)) || (h.size_size != sizeof(S)) || (h.level_size != sizeof(L)))
+        throw std::runtime_error("array_tree of different types");
+    // counts size the reads below, a truncated or foreign file must not overflow storage
+    if((h.leaf_count == 0) || !(h.leaf_count < h.node_capacity) ||
+        (h.node_count < h.leaf_count) || (h.node_count > h.node_capacity) ||
+        (h.node_capacity > uint64_t(std::numeric_limits<S>::max())))
+        throw std::runtime_error("array_tree with invalid counts");
+
+    array_tree<I, S, L> & tree = storage.init(S(h.leaf_count), S(h.node_capacity));
+    tree.node_count = S(h.node_count);
+    in.read(reinterpret_cast<char *>(tree.parents), tree.node_count*sizeof(I));
+    if(h.leaf_levels)
+        in.read(reinterpret_cast<char *>(tree.leaf_levels), tree.leaf_count*sizeof(L));
+    in.read(reinterpret_cast<char *>(tree.comp_levels), (tree.node_count-tree.leaf_count)*sizeof(L));
+    if(!in)
+        throw std::runtime_error("array_tree read failed");
+    return tree;
+}
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_IO_H_INCLUDED
@@ -0,0 +1,323 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_LCA_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_LCA_H_INCLUDED
+
+#include "cct/array_tree.h"
+
+#include "utils/parallel.h"
+
+#include <cstdint>
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+/** \brief Lowest common ancestor index for array_tree.
+ *
+ * Euler tour of components + range maximum query.
+ * Parents have bigger indices than their children (parents[i]+lc > i),
+ * so the LCA is simply the biggest component between first occurences in the tour.
+ * No depth array is needed.
+ *
+ * RMQ :
+ *  tour is split into 64 element blocks
+ *  in-block queries use a bitmask of the maximum stack for each position
+ *  whole blocks use a sparse table over block maxima
+ *
+ * init - O(node_count), queries - O(1)
+ *
+ * The level of LCA of two leaves is their ultrametric (minimax path) distance.
+ */
+template<typename Tree>
+class array_lca
+{
+public :
+    typedef typename Tree::index_type index_type;
+    typedef typename Tree::size_type  size_type;
+    typedef typename Tree::level_type level_type;
+
+private :
+    static constexpr unsigned block_bits = 6;
+    static constexpr size_type block_size = size_type(1) << block_bits;
+
+    Tree const * m_tree;
+
+    // component indices in order of euler tour
+    std::vector<index_type> m_tour;//[2*comp_count-root_count]
+    // first and last position of a component in the tour
+    std::vector<size_type> m_first;//[comp_count]
+    std::vector<size_type> m_last; //[comp_count]
+    // bit k of m_masks[i] is set if m_tour[block_begin+k] is maximum of [block_begin+k, i]
+    std::vector<uint64_t> m_masks;//[tour]
+    // m_table[k*block_count+i] = max of tour in blocks [i, i+2^k[
+    std::vector<index_type> m_table;//[block_count*log(block_count)]
+    size_type m_block_count;
+
+    static unsigned lowestBit(uint64_t x) noexcept
+    {
+        BOOST_ASSERT(x != 0);
+        return __builtin_ctzll(x);
+    }
+
+    static unsigned log2(size_type x) noexcept
+    {
+        BOOST_ASSERT(x != 0);
+        return 63 - __builtin_clzll(uint64_t(x));
+    }
+
+    void buildTour();
+    void buildTable();
+
+    /** Maximum of tour in [b, e], both in the same block */
+    index_type blockQuery(size_type b, size_type e) const noexcept
+    {
+        BOOST_ASSERT((b >> block_bits) == (e >> block_bits));
+        size_type const block_begin = (b >> block_bits) << block_bits;
+        uint64_t const mask = m_masks[e] & (~uint64_t(0) << (b-block_begin));
+        return m_tour[block_begin + lowestBit(mask)];
+    }
+
+    /** Maximum of tour in [b, e] */
+    index_type query(size_type b, size_type e) const noexcept
+    {
+        BOOST_ASSERT(b <= e);
+        BOOST_ASSERT(e < m_tour.size());
+        size_type const bb = b >> block_bits;
+        size_type const eb = e >> block_bits;
+        if(bb == eb)
+        {
+            return blockQuery(b, e);
+        }
+        // partial blocks
+        index_type m = std::max(
+            blockQuery(b, ((bb+1) << block_bits)-1),
+            blockQuery(eb << block_bits, e)
+        );
+        // whole blocks between them
+        if(bb+1 < eb)
+        {
+            unsigned const k = log2(eb-bb-1);
+            m = std::max(m, m_table[k*m_block_count + bb+1]);
+            m = std::max(m, m_table[k*m_block_count + eb-(size_type(1) << k)]);
+        }
+        return m;
+    }
+
+    /** \brief Component containing a node, root mark for isolated leaves. */
+    index_type component(size_type n) const noexcept
+    {
+        BOOST_ASSERT(n < m_tree->node_count);
+        return (n < m_tree->leaf_count)
+            ? m_tree->parents[n]
+            : index_type(n - m_tree->leaf_count);
+    }
+public :
+    array_lca()
+        : m_tree(nullptr), m_block_count(0)
+    {}
+
+    explicit array_lca(Tree const & tree)
+        : m_tree(nullptr), m_block_count(0)
+    {
+        init(tree);
+    }
+
+    array_lca(array_lca const &) = delete;
+    array_lca & operator=(array_lca const &) = delete;
+
+    /** \brief Index the tree.
+     * REQUIRES :
+     *  tree.build_children() was called
+     * Memory is kept between calls, so the index can be reused for many trees.
+     */
+    void init(Tree const & tree);
+
+    /** \brief Returned when nodes lie in different trees of a forest. */
+    static size_type none() noexcept
+    {
+        return std::numeric_limits<size_type>::max();
+    }
+
+    /** \brief Lowest common ancestor of two nodes.
+     * Nodes are node indices (leaf index for leaves).
+     * \returns node index of the LCA or none()
+     */
+    size_type lca(size_type a, size_type b) const noexcept
+    {
+        if(a == b)
+            return a;
+        index_type const root = m_tree->node_capacity - m_tree->leaf_count;
+        index_type const ca = component(a);
+        index_type const cb = component(b);
+        if((ca == root) || (cb == root))
+            return none();
+        size_type fa = m_first[ca];
+        size_type fb = m_first[cb];
+        if(fa > fb)
+            std::swap(fa, fb);
+        index_type const m = query(fa, fb);
+        // the maximum is a root of another tree
+        if((m_first[m] > fa) || (m_last[m] < fb))
+            return none();
+        return m + m_tree->leaf_count;
+    }
+
+    /** \brief Level of a node. Leaves without levels are at 0. */
+    level_type level(size_type n) const noexcept
+    {
+        BOOST_ASSERT(n < m_tree->node_count);
+        if(n >= m_tree->leaf_count)
+            return m_tree->comp_levels[n - m_tree->leaf_count];
+        return m_tree->leaf_levels ? m_tree->leaf_levels[n] : level_type(0);
+    }
+
+    /** \brief Ultrametric distance of two nodes = level of their LCA.
+     * \returns max(level_type) for nodes in different trees
+     */
+    level_type distance(size_type a, size_type b) const noexcept
+    {
+        size_type const n = lca(a, b);
+        if(n == none())
+            return std::numeric_limits<level_type>::max();
+        return level(n);
+    }
+
+    /** \brief Batch queries for node pairs (a[i], b[i]), i in [0, count[. */
+    void lca(
+        size_type const * a, size_type const * b,
+        size_type * result,//[count]
+        size_t count, unsigned threads = 1
+    ) const
+    {
+        utils::parallelFor(0, count, threads,
+            [&](size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; ++i)
+                    result[i] = lca(a[i], b[i]);
+            }
+        );
+    }
+
+    void distance(
+        size_type const * a, size_type const * b,
+        level_type * result,//[count]
+        size_t count, unsigned threads = 1
+    ) const
+    {
+        utils::parallelFor(0, count, threads,
+            [&](size_t begin, size_t end)
+            {
+                for(size_t i = begin; i < end; ++i)
+                    result[i] = distance(a[i], b[i]);
+            }
+        );
+    }
+};
+
+template<typename Tree>
+void array_lca<Tree>::init(Tree const & tree)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+    BOOST_ASSERT(tree.child_count);
+    BOOST_ASSERT(tree.children);
+    m_tree = &tree;
+    buildTour();
+    buildTable();
+}
+
+template<typename Tree>
+void array_lca<Tree>::buildTour()
+{
+    Tree const & t = *m_tree;
+    size_type const comp_count = t.node_count - t.leaf_count;
+    m_first.resize(comp_count);
+    m_last.resize(comp_count);
+    m_tour.clear();
+    m_tour.reserve(2*comp_count);
+    // (component, position of next child)
+    std::vector<std::pair<index_type, size_type>> stack;
+    // roots are stored after all nonroot nodes
+    for(size_type r = t.child_count[comp_count]; r < t.node_count; ++r)
+    {
+        if(t.children[r] < t.leaf_count)
+            continue;// isolated leaf
+        index_type const c = t.children[r] - t.leaf_count;
+        m_first[c] = m_tour.size();
+        m_tour.push_back(c);
+        stack.emplace_back(c, t.child_count[c]);
+        while(!stack.empty())
+        {
+            index_type const p = stack.back().first;
+            size_type & i = stack.back().second;
+            // skip leaves
+            while((i < t.child_count[p+1]) && (t.children[i] < t.leaf_count))
+                ++i;
+            if(i < t.child_count[p+1])
+            {
+                // descend to child component
+                index_type const n = t.children[i++] - t.leaf_count;
+                m_first[n] = m_tour.size();
+                m_tour.push_back(n);
+                stack.emplace_back(n, t.child_count[n]);
+            }
+            else
+            {
+                // return to parent
+                m_last[p] = m_tour.size()-1;
+                stack.pop_back();
+                if(!stack.empty())
+                    m_tour.push_back(stack.back().first);
+            }
+        }
+    }
+}
+
+template<typename Tree>
+void array_lca<Tree>::buildTable()
+{
+    size_type const n = m_tour.size();
+    m_masks.resize(n);
+    m_block_count = (n + block_size-1) >> block_bits;
+    unsigned const levels = (m_block_count > 0) ? log2(m_block_count)+1 : 0;
+    m_table.resize(levels*m_block_count);
+    // in-block stacks of maxima
+    for(size_type b = 0; b < m_block_count; ++b)
+    {
+        size_type const begin = b << block_bits;
+        size_type const end = std::min(begin+block_size, n);
+        uint64_t mask = 0;
+        for(size_type i = begin; i < end; ++i)
+        {
+            // pop smaller elements from the stack
+            while(mask != 0)
+            {
+                unsigned const top = 63 - __builtin_clzll(mask);
+                if(m_tour[begin+top] > m_tour[i])
+                    break;
+                mask &= ~(uint64_t(1) << top);
+            }
+            mask |= uint64_t(1) << (i-begin);
+            m_masks[i] = mask;
+        }
+        // maximum is at the bottom of the stack
+        m_table[b] = m_tour[begin + lowestBit(mask)];
+    }
+    // sparse table over blocks
+    for(unsigned k = 1; k < levels; ++k)
+    {
+        size_type const half = size_type(1) << (k-1);
+        index_type const * prev = &m_table[(k-1)*m_block_count];
+        index_type * curr = &m_table[k*m_block_count];
+        for(size_type b = 0; b + 2*half <= m_block_count; ++b)
+        {
+            curr[b] = std::max(prev[b], prev[b+half]);
+        }
+    }
+}
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_LCA_H_INCLUDED
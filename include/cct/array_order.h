@@ -0,0 +1,124 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_ORDER_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_ORDER_H_INCLUDED
+
+#include "cct/array_tree.h"
+
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+/** \brief Numbering of components. */
+enum class NodeOrder
+{
+    // order of merges, as produced by builders
+    Merge,
+    // reversed depth first pre-order, subtrees are contiguous
+    DepthFirst,
+    // reversed breadth first order, tree levels are contiguous
+    BreadthFirst,
+};
+
+/** \brief Renumber components in a traversal order.
+ *
+ * Traversal order is reversed, so the root gets the biggest index
+ * and parents[i]+lc > i still holds.
+ * Leaves keep their indices.
+ * Levels are no longer sorted by component index.
+ * Children are rebuilt afterwards.
+ * O(node_count)
+ *
+ * REQUIRES :
+ *  tree.build_children() was called
+ */
+template<typename I, typename S, typename L>
+void reorderTree(
+    array_tree<I, S, L> & tree,
+    NodeOrder order,
+    I * lut//[comp_count] old component index -> new component index
+)
+{
+    BOOST_ASSERT(tree.invalid_count == 0);
+    I const root = tree.node_capacity - tree.leaf_count;
+    S const lc = tree.leaf_count;
+    S const comp_count = tree.node_count - lc;
+
+    if(order == NodeOrder::Merge)
+    {
+        for(S c = 0; c < comp_count; ++c)
+            lut[c] = c;
+        return;
+    }
+
+    // components in traversal order
+    std::vector<I> visit;
+    visit.reserve(comp_count);
+    if(order == NodeOrder::DepthFirst)
+    {
+        std::vector<I> stack;
+        for(S r = tree.child_count[comp_count]; r < tree.node_count; ++r)
+        {
+            if(tree.children[r] < lc)
+                continue;// isolated leaf
+            stack.push_back(tree.children[r]-lc);
+            while(!stack.empty())
+            {
+                I const c = stack.back();
+                stack.pop_back();
+                visit.push_back(c);
+                // reversed, so the first child is visited first
+                for(S i = tree.child_count[c+1]; i-- > tree.child_count[c];)
+                {
+                    if(tree.children[i] >= lc)
+                        stack.push_back(tree.children[i]-lc);
+                }
+            }
+        }
+    }
+    else
+    {
+        BOOST_ASSERT(order == NodeOrder::BreadthFirst);
+        for(S r = tree.child_count[comp_count]; r < tree.node_count; ++r)
+        {
+            if(tree.children[r] >= lc)
+                visit.push_back(tree.children[r]-lc);
+        }
+        // visit is the queue
+        for(S q = 0; q < visit.size(); ++q)
+        {
+            I const c = visit[q];
+            for(S i = tree.child_count[c]; i < tree.child_count[c+1]; ++i)
+            {
+                if(tree.children[i] >= lc)
+                    visit.push_back(tree.children[i]-lc);
+            }
+        }
+    }
+    BOOST_ASSERT(visit.size() == comp_count);
+
+    for(S k = 0; k < comp_count; ++k)
+        lut[visit[k]] = comp_count-1-k;
+
+    // permute components
+    std::vector<I> parents(tree.parents+lc, tree.parents+tree.node_count);
+    std::vector<L> levels(tree.comp_levels, tree.comp_levels+comp_count);
+    for(S c = 0; c < comp_count; ++c)
+    {
+        I const p = parents[c];
+        tree.parents[lut[c]+lc] = (p == root) ? root : lut[p];
+        tree.comp_levels[lut[c]] = levels[c];
+    }
+    // relabel parents of leaves
+    for(S i = 0; i < lc; ++i)
+    {
+        if(tree.parents[i] != root)
+            tree.parents[i] = lut[tree.parents[i]];
+    }
+
+    tree.build_children();
+}
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_ORDER_H_INCLUDED
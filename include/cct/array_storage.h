@@ -0,0 +1,188 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_STORAGE_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_STORAGE_H_INCLUDED
+
+#include "cct/array_tree.h"
+#include "cct/root_finder.h"
+
+#include "utils/align.h"
+
+#include <algorithm>
+
+#include <boost/assert.hpp>
+#include <boost/scoped_array.hpp>
+
+/** \brief Owner of array_tree memory and builder workspace.
+ *
+ * All tree arrays and the merges buffer live in one aligned block.
+ * Memory only grows, so after the largest image was processed,
+ * building further trees does not allocate.
+ *
+ * Block layout (each array aligned to cache line) :
+ *  parents[node_capacity]
+ *  levels[node_capacity] - leaf_levels, comp_levels = levels+leaf_count
+ *  child_count[node_capacity-leaf_count+3]
+ *  children[node_capacity]
+ *  merges[max(leaf_count, node_capacity-leaf_count+1)]
+ */
+template<typename IndexType, typename SizeType, typename LevelType>
+class array_tree_storage
+{
+public :
+    typedef array_tree<IndexType, SizeType, LevelType> tree_type;
+    typedef cct::PackedRootFinder<SizeType, IndexType> root_finder_type;
+
+    typedef IndexType index_type;
+    typedef SizeType  size_type;
+    typedef LevelType level_type;
+private :
+    static constexpr size_t alignment = 64;//usual cache line size
+
+    boost::scoped_array<char> m_memory;
+    size_t m_capacity;// bytes
+
+    // scratch memory, e.g. for edges
+    boost::scoped_array<char> m_buffer;
+    size_t m_buffer_capacity;// bytes
+
+    tree_type m_tree;
+    index_type * m_merges;
+
+    root_finder_type m_root;
+
+    template<typename T>
+    static size_t arraySize(size_t count)
+    {
+        return utils::alignSize(count*sizeof(T), alignment);
+    }
+public :
+    array_tree_storage()
+        : m_capacity(0), m_buffer_capacity(0), m_merges(nullptr)
+    {
+        m_tree.leaf_count = 0;
+        m_tree.node_count = 0;
+        m_tree.node_capacity = 0;
+        m_tree.invalid_count = 0;
+        m_tree.parents = nullptr;
+        m_tree.leaf_levels = nullptr;
+        m_tree.comp_levels = nullptr;
+        m_tree.child_count = nullptr;
+        m_tree.children = nullptr;
+    }
+
+    // storage is noncopyable
+    array_tree_storage(array_tree_storage const &) = delete;
+    array_tree_storage & operator=(array_tree_storage const &) = delete;
+
+    /** \brief Prepare empty tree with given leaf count.
+     *
+     * node_capacity == 0 -> leaf_count*2-1 (BPT), leaf_count+1 for a single leaf
+     * Reallocates only if the current block is too small.
+     * \returns reset tree
+     */
+    tree_type & init(size_type leaf_count, size_type node_capacity = 0)
+    {
+        BOOST_ASSERT(leaf_count > 0);
+        // a single leaf is the root, but root marker node_capacity-leaf_count must not be 0
+        if(node_capacity == 0)
+            node_capacity = std::max<size_type>(2*leaf_count-1, leaf_count+1);
+        BOOST_ASSERT(node_capacity > leaf_count);
+
+        size_type const comp_capacity = node_capacity-leaf_count;
+        size_t const parents_size     = arraySize<index_type>(node_capacity);
+        size_t const levels_size      = arraySize<level_type>(node_capacity);
+        size_t const child_count_size = arraySize<size_type >(comp_capacity+3);
+        size_t const children_size    = arraySize<size_type >(node_capacity);
+        size_t const merges_size      = arraySize<index_type>(std::max<size_t>(leaf_count, comp_capacity+1));
+        size_t const size = alignment-1
+            + parents_size + levels_size + child_count_size + children_size + merges_size;
+        if(size > m_capacity)
+        {
+            m_memory.reset();
+            m_memory.reset(new char[size]);
+            m_capacity = size;
+        }
+        char * ptr = utils::alignPtr(m_memory.get(), alignment);
+        m_tree.parents = reinterpret_cast<index_type *>(ptr);
+        ptr += parents_size;
+        m_tree.leaf_levels = reinterpret_cast<level_type *>(ptr);
+        ptr += levels_size;
+        m_tree.child_count = reinterpret_cast<size_type *>(ptr);
+        ptr += child_count_size;
+        m_tree.children = reinterpret_cast<size_type *>(ptr);
+        ptr += children_size;
+        m_merges = reinterpret_cast<index_type *>(ptr);
+
+        m_tree.leaf_count = leaf_count;
+        m_tree.node_count = leaf_count;
+        m_tree.node_capacity = node_capacity;
+        m_tree.invalid_count = 0;
+        m_tree.comp_levels = m_tree.leaf_levels + leaf_count;
+        m_tree.reset();
+        return m_tree;
+    }
+
+    /** \brief Free all memory. */
+    void kill() noexcept
+    {
+        m_root.kill();
+        m_buffer.reset();
+        m_buffer_capacity = 0;
+        m_memory.reset();
+        m_capacity = 0;
+        m_merges = nullptr;
+        m_tree.leaf_count = 0;
+        m_tree.node_count = 0;
+        m_tree.node_capacity = 0;
+        m_tree.parents = nullptr;
+        m_tree.leaf_levels = nullptr;
+        m_tree.comp_levels = nullptr;
+        m_tree.child_count = nullptr;
+        m_tree.children = nullptr;
+    }
+
+    tree_type & tree() noexcept
+    {
+        return m_tree;
+    }
+    tree_type const & tree() const noexcept
+    {
+        return m_tree;
+    }
+
+    /** \brief Scratch buffer for node merging, see array_tree::alpha_merge */
+    index_type * merges() noexcept
+    {
+        return m_merges;
+    }
+
+    /** \brief Root finder over leaves, it is (re)initialized by the user. */
+    root_finder_type & root_finder() noexcept
+    {
+        return m_root;
+    }
+
+    /** \brief Uninitialized scratch array of trivial type, e.g. graph edges.
+     *
+     * Content is not preserved between calls.
+     */
+    template<typename T>
+    T * buffer(size_t count)
+    {
+        size_t const size = alignment-1 + arraySize<T>(count);
+        if(size > m_buffer_capacity)
+        {
+            m_buffer.reset();
+            m_buffer.reset(new char[size]);
+            m_buffer_capacity = size;
+        }
+        return reinterpret_cast<T *>(utils::alignPtr(m_buffer.get(), alignment));
+    }
+
+    /** \brief Allocated bytes */
+    size_t capacity() const noexcept
+    {
+        return m_capacity + m_buffer_capacity;
+    }
+};
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_STORAGE_H_INCLUDED
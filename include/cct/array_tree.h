@@ -1,5 +1,9 @@
+#ifndef CONNECTED_COMPONENT_TREE_ARRAY_TREE_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_ARRAY_TREE_H_INCLUDED
+
 #include <cstring>
 
+#include <algorithm>
 #include <utility>
 
 #include <boost/assert.hpp>
@@ -176,7 +180,7 @@ struct array_tree
         // index to mark root node
         index_type const root = node_capacity-leaf_count;
         //for all nonroot & nonleaf nodes
-        for(size_type n = node_count; n >= leaf_count; --n)
+        for(size_type n = node_count; n-- > leaf_count;)
         {
             index_type const c = n-leaf_count;//component index of node
             index_type const p = parents[n];// component index of parent
@@ -297,20 +301,77 @@ struct array_tree
                 {
                     size_type const n = count++;
                     parents[n+leaf_count] = parents[i+leaf_count];
-                    comp_levels[n+leaf_count] = comp_levels[n+leaf_count];
+                    comp_levels[n] = comp_levels[i];
                     lut[i] = n;
                 }
             }
             node_count = leaf_count+count;
             invalid_count = 0;
             // set correct parents for all nodes
+            // root mark is not a component, it stays the same
+            index_type const root = node_capacity-leaf_count;
             for(size_type i = 0; i < node_count; ++i)
             {
-                parents[i] = lut[parents[i]];
+                if(parents[i] != root)
+                    parents[i] = lut[parents[i]];
             }
         }
     }
 
+    /** \brief Splice out components with less than two children.
+     *
+     * Children of a removed component are linked to its nearest kept ancestor,
+     * or become roots. The tree is compressed afterwards.
+     * Two trees of the same image become structurally comparable.
+     * O(node_count)
+     *
+     * \returns number of removed components
+     */
+    size_type remove_degenerates(
+            index_type * lut//[node_count-leaf_count]
+            )
+    {
+        BOOST_ASSERT(invalid_count == 0);
+        // index to mark root node
+        index_type const root = node_capacity-leaf_count;
+        size_type const comp_count = node_count-leaf_count;
+        // count children into lut
+        std::fill_n(lut, comp_count, 0);
+        for(size_type i = 0; i < node_count; ++i)
+        {
+            if(parents[i] != root)
+                ++lut[parents[i]];
+        }
+        // traverse tree from root to leaves
+        // lut[i] = i for kept components
+        // lut[i] = nearest kept ancestor (or root) for removed ones
+        for(size_type i = comp_count; i-- > 0;)
+        {
+            index_type const p = parents[i+leaf_count];
+            index_type const q = (p == root) ? root : lut[p];
+            if(lut[i] > 1)
+            {
+                lut[i] = i;
+                parents[i+leaf_count] = q;
+            }
+            else
+            {
+                lut[i] = q;
+                parents[i+leaf_count] = 0;
+                ++invalid_count;
+            }
+        }
+        // set parents for leaves
+        for(size_type i = 0; i < leaf_count; ++i)
+        {
+            if(parents[i] != root)
+                parents[i] = lut[parents[i]];
+        }
+        size_type const removed = invalid_count;
+        compress(lut);
+        return removed;
+    }
+
     // count
     // {0, 0,
     //  count[2+0] = count 0
@@ -367,3 +428,5 @@ struct array_tree
         }
     }
 };
+
+#endif//CONNECTED_COMPONENT_TREE_ARRAY_TREE_H_INCLUDED
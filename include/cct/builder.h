@@ -1,3 +1,4 @@
+#include "arena.h"
 #include "node.h"
 #include "root_finder.h"
 
@@ -13,6 +14,7 @@ template<typename TreeType>
 class Builder;
 
 /* \brief ThreadBuilder holds thread specific state
+ * - slab allocator in the tree arena
  * - object pool
  * - component count
  * - root list
@@ -84,7 +86,31 @@ public :
         return m_tree;
     }
 
+    /** \brief Make room for builder_count thread builders, before building starts.
+     *
+     * See Tree::reserveBuilders.
+     */
+    void reserveBuilders(size_type builder_count)
+    {
+        BOOST_ASSERT(m_tree);
+        m_tree->reserveBuilders(builder_count);
+    }
+
     void finish(ThreadBuilder<Builder> && tb);
+
+private :
+    // opposite of finish, see ThreadBuilder::adopt
+    template<typename List>
+    void takeRoots(List & list)
+    {
+        BOOST_ASSERT(m_tree);
+        while(!m_tree->roots.empty())
+        {
+            Component & root = m_tree->roots.front();
+            m_tree->roots.pop_front();
+            list.push_back(root);
+        }
+    }
 };
 
 template<typename BuilderType>
@@ -100,11 +126,7 @@ public :
 private :
     friend class cct::Builder<Tree>;
 
-    typedef boost::intrusive::list<
-            Component,
-            boost::intrusive::size_type<typename Builder::size_type>,
-            boost::intrusive::constant_time_size<false>
-        > Components;
+    typedef typename Tree::ComponentList Components;
 
     Builder & m_builder;
 
@@ -122,6 +144,9 @@ private :
     // Component pool
     Components m_pool;
 
+    // Allocator of new components, memory is owned by the tree
+    NodeSlab<typename Tree::Arena> m_slab;
+
     template<typename Edge>
     Component * alloc(Edge const & edge);
 
@@ -150,12 +175,18 @@ private :
         return std::make_tuple(a, b);
     }
 
-    // Implementation of merge_paths
-    template<typename Edge>
-    void merge_paths(Leaf * la, Leaf * lb, Edge const & edge);
+    // Implementation of merge_paths, la and lb are leaves or components below edge
+    template<typename NodeA, typename NodeB, typename Edge>
+    void merge_paths(NodeA * la, NodeB * lb, Edge const & edge);
+
+    /** \brief Unlink node from its parent.
+     * returns the parent, if it is not above bound
+     */
+    template<typename Node, typename Edge, typename Boundary>
+    Component * cut(Node * node, size_type leaf, Edge const & bound, Boundary & boundary);
 public :
     explicit ThreadBuilder(Builder & b)
-        : m_builder(b), m_component_count(0)
+        : m_builder(b), m_component_count(0), m_slab(b.m_tree->arena())
     {}
 
     ThreadBuilder(ThreadBuilder const &) = delete;
@@ -183,6 +214,23 @@ public :
      */
     void absorb(ThreadBuilder && b);
 
+    /** \brief Take over all roots of the tree, e.g. the forest of image::buildAlphaTreeNomerge.
+     *
+     * Their trees can then be merged by merge_roots and merge_paths,
+     * Builder::finish moves the roots back.
+     * REQUIRES :
+     *  builder was not reset since the trees were built
+     */
+    void adopt();
+
+    /** \brief Move n free components to the pool of b.
+     *
+     * Pool is refilled from the slab, if it runs out.
+     * b can then create n components without taking a new block of the arena.
+     */
+    template<typename Edge>
+    void lend(ThreadBuilder & b, size_type n, Edge const & edge);
+
     // Singlethreaded construction :
 
     /**
@@ -221,6 +269,41 @@ public :
      */
     template<typename Edge>
     void merge_paths(size_type a, size_type b, Edge const & edge);
+
+    /** \brief Merge two paths in a tree, starting above the leaves.
+     * Same as merge_paths(a, b, edge), if na and nb lie on the paths of leaves a and b.
+     * nullptr stands for the leaf itself.
+     *
+     * REQUIRES :
+     *  na < edge, nb < edge
+     */
+    template<typename Edge>
+    void merge_paths(size_type a, Component * na, size_type b, Component * nb, Edge const & edge);
+
+    /** \brief Merge two paths in a tree up to the bound level.
+     *
+     * Same as merge_paths(a, na, b, nb, edge) for components at or below bound,
+     * components above it are shared with other threads and stay as they are.
+     * Children are linked to them or unlinked from them only through boundary :
+     *  boundary.unlink(node, leaf) - unlink node, leaf is below the node
+     *  boundary.link(node) - link node to the parent, which lost a child last
+     * Paths of the leaves up to bound must not be touched by other threads.
+     *
+     * REQUIRES :
+     *  na < edge, nb < edge
+     *  edge <= bound < root level
+     */
+    template<typename Edge, typename Boundary>
+    void merge_paths_below(
+        size_type a, Component * na, size_type b, Component * nb,
+        Edge const & edge, Edge const & bound,
+        Boundary & boundary
+    );
+
+    /** \brief Delete component without children.
+     * \returns its parent
+     */
+    Component * erase(Component * node);
 };
 
 #include "builder.inl"
@@ -22,10 +22,30 @@ void Builder<Tree>::finish(ThreadBuilder<Builder<Tree>> && tb)
 template<typename BuilderType>
 ThreadBuilder<BuilderType>::~ThreadBuilder() noexcept
 {
-    // TODO : roots and subtrees will leak
-    // TODO : redundant nodes and subtrees will leak
-    // clear pool
-    m_pool.clear_and_dispose(std::default_delete<Component>());
+    // redundant nodes go to the pool
+    remove();
+    // unfinished trees are dropped, their leaves are unlinked
+    Components dropped;
+    dropped.splice(dropped.end(), m_roots);
+    for(Component & node : dropped)
+    {
+        while(!node.empty())
+        {
+            typename Tree::Node & child = *node.begin();
+            child.unlink();
+            if(tree().isNodeComponent(child))
+                dropped.push_back(static_cast<Component &>(child));
+        }
+        --m_component_count;
+    }
+    m_pool.splice(m_pool.end(), dropped);
+    // memory of all nodes is owned by the tree arena, it is reused by other builders
+    while(!m_pool.empty())
+    {
+        Component & node = m_pool.front();
+        m_pool.pop_front();
+        m_slab.destroy(&node);
+    }
 }
 
 template<typename BuilderType>
@@ -36,7 +56,7 @@ ThreadBuilder<BuilderType>::alloc(Edge const & edge)
     Component * node = nullptr;
     if(m_pool.empty())
     {
-        node = new Component(edge);
+        node = m_slab.create(edge);
     }
     else
     {
@@ -128,6 +148,33 @@ void ThreadBuilder<B>::absorb(ThreadBuilder<B> && b)
     m_roots.splice(m_roots.end(), b.m_roots);
     // transfer node pool
     m_pool.splice(m_pool.end(), b.m_pool);
+    // keep the larger unused block rest
+    m_slab.absorb(b.m_slab);
+}
+
+template<typename B>
+void ThreadBuilder<B>::adopt()
+{
+    // component count of the roots stays in the tree, finish adds only the difference
+    m_builder.takeRoots(m_roots);
+}
+
+template<typename B>
+template<typename Edge>
+void ThreadBuilder<B>::lend(ThreadBuilder<B> & b, size_type n, Edge const & edge)
+{
+    BOOST_ASSERT(&m_builder == &(b.m_builder));
+    // pooled nodes are not counted
+    for(; (n > 0) && !m_pool.empty(); --n)
+    {
+        Component & node = m_pool.front();
+        m_pool.pop_front();
+        b.m_pool.push_front(node);
+    }
+    for(; n > 0; --n)
+    {
+        b.m_pool.push_front(*m_slab.create(edge));
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -203,6 +250,24 @@ ThreadBuilder<B>::addEdge(
     }
 }
 
+template<typename B>
+template<typename Vertex>
+void ThreadBuilder<B>::addVertex(size_type i, Vertex const & vertex)
+{
+    BOOST_ASSERT(tree().isLeafId(i));
+
+    typedef typename Builder::Handle Handle;
+    // Lookup root
+    Handle h = m_builder.m_rootFinder.find_update(i);
+    // vertex must be added before edges of the same or higher level
+    BOOST_ASSERT(!m_builder.m_rootFinder.data(h));
+    // lift leaf to vertex level
+    Component * node = alloc(vertex);
+    node->link(tree().leaf(i));
+    m_roots.push_back(*node);
+    m_builder.m_rootFinder.data(h) = node;
+}
+
 template<typename B>
 void ThreadBuilder<B>::remove()
 {
@@ -339,7 +404,31 @@ void ThreadBuilder<B>::merge_paths(size_type a, size_type b, Edge const & edge)
 
 template<typename B>
 template<typename Edge>
-void ThreadBuilder<B>::merge_paths(Leaf * la, Leaf * lb, Edge const & edge)
+void ThreadBuilder<B>::merge_paths(size_type a, Component * na, size_type b, Component * nb, Edge const & edge)
+{
+    BOOST_ASSERT(!na || (*na < edge));
+    BOOST_ASSERT(!nb || (*nb < edge));
+    if(na && nb)
+    {
+        merge_paths(na, nb, edge);
+    }
+    else if(na)
+    {
+        merge_paths(na, tree().leaf(b), edge);
+    }
+    else if(nb)
+    {
+        merge_paths(tree().leaf(a), nb, edge);
+    }
+    else
+    {
+        merge_paths(tree().leaf(a), tree().leaf(b), edge);
+    }
+}
+
+template<typename B>
+template<typename NodeA, typename NodeB, typename Edge>
+void ThreadBuilder<B>::merge_paths(NodeA * la, NodeB * lb, Edge const & edge)
 {
     Component * na = static_cast<Component*>(la->parent());
     Component * nb = static_cast<Component*>(lb->parent());
@@ -349,8 +438,8 @@ void ThreadBuilder<B>::merge_paths(Leaf * la, Leaf * lb, Edge const & edge)
     // ensure node relationship to simplify following code
     if(*na < *nb)
     {
-        std::swap(la, lb);
-        std::swap(na, nb);
+        merge_paths(lb, la, edge);
+        return;
     }
     // NOW : na >= nb (+ na, nb != null)
     BOOST_ASSERT(*nb <= *na);
@@ -693,6 +782,165 @@ void ThreadBuilder<B>::merge_paths(Leaf * la, Leaf * lb, Edge const & edge)
     //}
 }
 
+template<typename B>
+template<typename Node, typename Edge, typename Boundary>
+typename ThreadBuilder<B>::Component *
+ThreadBuilder<B>::cut(Node * node, size_type leaf, Edge const & bound, Boundary & boundary)
+{
+    Component * p = static_cast<Component*>(node->parent());
+    if(!p)
+    {
+        return nullptr;
+    }
+    if(*p <= bound)
+    {
+        node->unlink();
+        return p;
+    }
+    boundary.unlink(node, leaf);
+    return nullptr;
+}
+
+template<typename B>
+template<typename Edge, typename Boundary>
+void ThreadBuilder<B>::merge_paths_below(
+    size_type a, Component * na, size_type b, Component * nb,
+    Edge const & edge, Edge const & bound,
+    Boundary & boundary
+)
+{
+    BOOST_ASSERT(!na || (*na < edge));
+    BOOST_ASSERT(!nb || (*nb < edge));
+    // highest component <= edge above a leaf, nullptr if the leaf itself
+    auto insertionPoint = [&](Leaf * l, Component * n)
+    {
+        Component * p = static_cast<Component*>(n ? n->parent() : l->parent());
+        while(p && (*p <= edge))
+        {
+            n = p;
+            p = static_cast<Component*>(p->parent());
+        }
+        return n;
+    };
+    Leaf * la = tree().leaf(a);
+    Leaf * lb = tree().leaf(b);
+    na = insertionPoint(la, na);
+    nb = insertionPoint(lb, nb);
+    if(na && (na == nb))
+    {
+        // paths are already merged
+        return;
+    }
+    // nodes at edge level are reused, na is the bigger one
+    auto atEdge = [&](Component * n) { return n && !(*n < edge); };
+    if(atEdge(nb) && (!atEdge(na) || (Component::constant_time_children_size &&
+        (na->children.size() < nb->children.size()))))
+    {
+        std::swap(a, b);
+        std::swap(la, lb);
+        std::swap(na, nb);
+    }
+    //   node <- edge
+    //   /  |
+    //  ?   ?
+    //  |   |
+    //  la  lb
+    Component * node = nullptr;
+    // rest of both paths below bound, nullptr where they end
+    Component * pa = nullptr;
+    Component * pb = nullptr;
+    if(atEdge(na))
+    {
+        node = na;
+        pa = cut(na, a, bound, boundary);
+    }
+    else
+    {
+        node = alloc(edge);
+        if(na)
+        {
+            pa = cut(na, a, bound, boundary);
+            node->link(na);
+        }
+        else
+        {
+            pa = cut(la, a, bound, boundary);
+            node->link(la);
+        }
+    }
+    if(atEdge(nb))
+    {
+        reconnect(nb, node);
+        pb = cut(nb, b, bound, boundary);
+        --m_component_count;
+        m_pool.push_front(*nb);
+    }
+    else if(nb)
+    {
+        pb = cut(nb, b, bound, boundary);
+        node->link(nb);
+    }
+    else
+    {
+        pb = cut(lb, b, bound, boundary);
+        node->link(lb);
+    }
+    // zip like merge_paths, until paths converge or one of them ends
+    while(pa && pb && (pa != pb))
+    {
+        Component * n = nullptr;
+        if(*pa < *pb)
+        {
+            n = pa;
+            pa = cut(pa, a, bound, boundary);
+        }
+        else if(*pb < *pa)
+        {
+            n = pb;
+            pb = cut(pb, b, bound, boundary);
+        }
+        else
+        {
+            // When size is constant time, ensure smaller node is removed
+            if(Component::constant_time_children_size &&
+                (pa->children.size() < pb->children.size()))
+            {
+                std::swap(a, b);
+                std::swap(pa, pb);
+            }
+            n = pa;
+            pa = cut(pa, a, bound, boundary);
+            reconnect(pb, n);
+            Component * old = pb;
+            pb = cut(pb, b, bound, boundary);
+            --m_component_count;
+            m_pool.push_front(*old);
+        }
+        n->link(node);
+        node = n;
+    }
+    if(Component * p = pa ? pa : pb)
+    {
+        // the other path continues above the bound
+        p->link(node);
+    }
+    else
+    {
+        boundary.link(node);
+    }
+}
+
+template<typename B>
+typename ThreadBuilder<B>::Component *
+ThreadBuilder<B>::erase(Component * node)
+{
+    BOOST_ASSERT(node->empty());
+    Component * p = static_cast<Component*>(node->unlink());
+    --m_component_count;
+    m_pool.push_front(*node);
+    return p;
+}
+
 #if 0
 template<typename B>
 template<typename Edge>
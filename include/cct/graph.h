@@ -4,11 +4,21 @@
 #include <cstdint>
 
 #include <algorithm>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
 
 namespace cct {
 
 namespace graph {
 
+/** \brief Weighted edge of a general graph
+ *
+ * Vertices are indices in [0, vertex_count[.
+ */
 template<typename V, typename W>
 struct Edge
 {
@@ -22,21 +32,105 @@ struct Edge
     bool operator<(Edge const & e) const
     {
         return weight < e.weight;
-    } 
+    }
 };
 
-template<typename V, typename W, typename EdgeWeightFunction> 
+// Extraction of graph edges
+
+/** \brief Extracts edges of graph in compressed sparse row form.
+ *
+ * Neighbours of v are adjacency[offsets[v]] .. adjacency[offsets[v+1]-1].
+ * Every edge is expected in the lists of both its vertices,
+ * it is extracted once, from the vertex with the lower index.
+ * One-sided lists (e.g. k-NN graphs) lose edges listed only by the higher vertex,
+ * run symmetrize on them first.
+ * Self loops are skipped.
+ */
+template<typename V, typename O, typename W, typename EdgeWeightFunction>
+size_t getEdges(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    Edge<V, W> * edges,//[offsets[vertex_count]]
+    EdgeWeightFunction e//e(V, V)
+);
+
+/** \brief Extracts edges of graph in compressed sparse row form with stored weights.
+ *
+ * weights[k] is the weight of edge to adjacency[k].
+ */
+template<typename V, typename O, typename W>
+size_t getEdges(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    W const * weights,//[offsets[vertex_count]]
+    Edge<V, W> * edges//[offsets[vertex_count]]
+);
+
+/** \brief Symmetric form of graph in compressed sparse row form.
+ *
+ * Every neighbour u of v is also listed as neighbour of v by u,
+ * lists are sorted, duplicates and self loops are removed.
+ * Needed by getEdges for graphs with one-sided lists, e.g. k-NN graphs.
+ * O(|E|log(degree))
+ */
+template<typename V, typename O>
+void symmetrize(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    std::vector<O> & sym_offsets,//[vertex_count+1]
+    std::vector<V> & sym_adjacency
+);
+
+/** \brief Symmetric form of graph in compressed sparse row form with stored weights.
+ *
+ * Edge listed by both its vertices gets the lower of both weights.
+ */
+template<typename V, typename O, typename W>
+void symmetrize(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    W const * weights,//[offsets[vertex_count]]
+    std::vector<O> & sym_offsets,//[vertex_count+1]
+    std::vector<V> & sym_adjacency,
+    std::vector<W> & sym_weights
+);
+
+/** \brief Stable sort of edges by weight.
+ *
+ * Depending on edge weight :
+ *  unsigned integer - O(|E|*sizeof(W))
+ *   LSD radix sort by bytes, passes with a single bucket are skipped
+ *  otherwise - O(|E|log|E|)
+ *   std::stable_sort
+ * Sorted edges are in edges, buffer is scratch memory.
+ */
+template<typename V, typename W>
+void sortEdges(
+    Edge<V, W> * edges,//[count]
+    size_t count,
+    Edge<V, W> * buffer//[count]
+);
+
+template<typename V, typename W>
+void sortEdges(
+    Edge<V, W> * edges,//[count]
+    size_t count
+);
+
+/** \brief Extracts edges of graph in compressed sparse row form and sorts them
+ */
+template<typename V, typename O, typename W, typename EdgeWeightFunction>
 size_t getSortedEdges(
-    V beg, V end, // vertex range
-    Edge<V, W> * edges,//[end-beg]
-    EdgeFunction f//f(V)
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    Edge<V, W> * edges,//[offsets[vertex_count]]
+    EdgeWeightFunction e//e(V, V)
 );
-//template<typename V, typename EdgeWeightFunction> 
-//size_t getSortedEdges(
-//    V beg, V end, // vertex range
-//    Edge<V, uint8_t> * edges,//[end-beg]
-//    EdgeWeightFunction e//f(V)
-//);
 
 #include "graph.inl"
 
@@ -1,29 +1,242 @@
-template<typename V, typename W, typename EdgeWeightFunction> 
-size_t getSortedEdges(
-    V beg, V end, // vertex range
-    Edge<V, W> * edges,//[end-beg]
-    EdgeFunction e//f(V)
+template<typename V, typename O, typename W, typename EdgeWeightFunction>
+size_t getEdges(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    Edge<V, W> * edges,//[offsets[vertex_count]]
+    EdgeWeightFunction e//e(V, V)
 )
 {
     size_t count = 0;
-    for(V v = beg; v < end; ++v)
+    for(V v = 0; v < vertex_count; ++v)
     {
-//        edges[count].vertices[0] = v;
-        edges[count++] = f(v);
-        //auto e = f(v);
-        //if(e)
-        //{
-        //    edges[count++] = *e;
-        //}
+        for(O k = offsets[v]; k < offsets[v+1]; ++k)
+        {
+            V const u = adjacency[k];
+            BOOST_ASSERT(u < vertex_count);
+            if(v < u)
+            {
+                BOOST_ASSERT(count < size_t(offsets[vertex_count]));
+                Edge<V, W> & edge = edges[count++];
+                edge.vertices[0] = v;
+                edge.vertices[1] = u;
+                edge.weight = e(v, u);
+            }
+        }
     }
-    std::sort(edges, edges+count);
     return count;
 }
 
-//template<typename V, typename EdgeWeightFunction> 
-//size_t getSortedEdges(
-//    V beg, V end, // vertex range
-//    Edge<V, uint8_t> * edges,//[end-beg]
-//    EdgeWeightFunction f,//f(V)
-//)
+template<typename V, typename O, typename W>
+size_t getEdges(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    W const * weights,//[offsets[vertex_count]]
+    Edge<V, W> * edges//[offsets[vertex_count]]
+)
+{
+    size_t count = 0;
+    for(V v = 0; v < vertex_count; ++v)
+    {
+        for(O k = offsets[v]; k < offsets[v+1]; ++k)
+        {
+            V const u = adjacency[k];
+            BOOST_ASSERT(u < vertex_count);
+            if(v < u)
+            {
+                BOOST_ASSERT(count < size_t(offsets[vertex_count]));
+                Edge<V, W> & edge = edges[count++];
+                edge.vertices[0] = v;
+                edge.vertices[1] = u;
+                edge.weight = weights[k];
+            }
+        }
+    }
+    return count;
+}
 
+// both directions of every arc, weights[k] or 0 per entry
+template<typename V, typename O, typename Entry, typename GetWeight>
+void symmetricEntries(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    GetWeight weight,//weight(k)
+    std::vector<O> & sym_offsets,//[vertex_count+1]
+    std::vector<Entry> & entries//[sym_offsets[vertex_count]]
+)
+{
+    sym_offsets.assign(size_t(vertex_count)+1, 0);
+    for(V v = 0; v < vertex_count; ++v)
+    {
+        for(O k = offsets[v]; k < offsets[v+1]; ++k)
+        {
+            V const u = adjacency[k];
+            BOOST_ASSERT(u < vertex_count);
+            if(u != v)
+            {
+                ++sym_offsets[v+1];
+                ++sym_offsets[u+1];
+            }
+        }
+    }
+    std::partial_sum(sym_offsets.begin(), sym_offsets.end(), sym_offsets.begin());
+    entries.resize(sym_offsets[vertex_count]);
+    std::vector<O> ends(sym_offsets.begin(), sym_offsets.end()-1);
+    for(V v = 0; v < vertex_count; ++v)
+    {
+        for(O k = offsets[v]; k < offsets[v+1]; ++k)
+        {
+            V const u = adjacency[k];
+            if(u != v)
+            {
+                entries[ends[v]++] = Entry(u, weight(k));
+                entries[ends[u]++] = Entry(v, weight(k));
+            }
+        }
+    }
+    // sort lists, keep first (lowest weight) entry of every neighbour
+    O count = 0;
+    for(V v = 0; v < vertex_count; ++v)
+    {
+        O const first = count;
+        std::sort(entries.begin()+sym_offsets[v], entries.begin()+sym_offsets[v+1]);
+        for(O k = sym_offsets[v]; k < sym_offsets[v+1]; ++k)
+        {
+            if((count == first) || (entries[count-1].first != entries[k].first))
+                entries[count++] = entries[k];
+        }
+        sym_offsets[v] = first;
+    }
+    sym_offsets[vertex_count] = count;
+    entries.resize(count);
+}
+
+template<typename V, typename O>
+void symmetrize(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    std::vector<O> & sym_offsets,//[vertex_count+1]
+    std::vector<V> & sym_adjacency
+)
+{
+    typedef std::pair<V, bool> Entry;
+    std::vector<Entry> entries;
+    symmetricEntries(vertex_count, offsets, adjacency, [](O) { return false; }, sym_offsets, entries);
+    sym_adjacency.resize(entries.size());
+    for(size_t k = 0; k < entries.size(); ++k)
+        sym_adjacency[k] = entries[k].first;
+}
+
+template<typename V, typename O, typename W>
+void symmetrize(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    W const * weights,//[offsets[vertex_count]]
+    std::vector<O> & sym_offsets,//[vertex_count+1]
+    std::vector<V> & sym_adjacency,
+    std::vector<W> & sym_weights
+)
+{
+    typedef std::pair<V, W> Entry;
+    std::vector<Entry> entries;
+    symmetricEntries(vertex_count, offsets, adjacency, [weights](O k) { return weights[k]; }, sym_offsets, entries);
+    sym_adjacency.resize(entries.size());
+    sym_weights.resize(entries.size());
+    for(size_t k = 0; k < entries.size(); ++k)
+    {
+        sym_adjacency[k] = entries[k].first;
+        sym_weights[k] = entries[k].second;
+    }
+}
+
+// comparison sort for weights without radix keys
+template<typename V, typename W>
+void sortEdges(
+    Edge<V, W> * edges,//[count]
+    size_t count,
+    Edge<V, W> *,//[count]
+    std::false_type//radix
+)
+{
+    std::stable_sort(edges, edges+count);
+}
+
+// LSD radix sort by bytes of unsigned weight
+template<typename V, typename W>
+void sortEdges(
+    Edge<V, W> * edges,//[count]
+    size_t count,
+    Edge<V, W> * buffer,//[count]
+    std::true_type//radix
+)
+{
+    size_t const bytes = sizeof(W);
+    // histograms of all bytes in one pass
+    std::vector<size_t> histograms(bytes*256, 0);
+    for(size_t i = 0; i < count; ++i)
+    {
+        W const w = edges[i].weight;
+        for(size_t b = 0; b < bytes; ++b)
+        {
+            ++histograms[b*256 + ((w >> (8*b)) & 0xFF)];
+        }
+    }
+    Edge<V, W> * in = edges;
+    Edge<V, W> * out = buffer;
+    size_t indices[256];
+    for(size_t b = 0; b < bytes; ++b)
+    {
+        size_t const * histogram = histograms.data() + b*256;
+        // all edges share this byte, order is kept
+        if(std::find(histogram, histogram+256, count) != histogram+256)
+            continue;
+        indices[0] = 0;
+        std::partial_sum(histogram, histogram + 255, indices + 1);
+        for(size_t i = 0; i < count; ++i)
+        {
+            out[indices[(in[i].weight >> (8*b)) & 0xFF]++] = in[i];
+        }
+        std::swap(in, out);
+    }
+    if(in != edges)
+        std::copy(in, in+count, edges);
+}
+
+template<typename V, typename W>
+void sortEdges(
+    Edge<V, W> * edges,//[count]
+    size_t count,
+    Edge<V, W> * buffer//[count]
+)
+{
+    sortEdges(edges, count, buffer,
+        std::integral_constant<bool, std::is_integral<W>::value && std::is_unsigned<W>::value>());
+}
+
+template<typename V, typename W>
+void sortEdges(
+    Edge<V, W> * edges,//[count]
+    size_t count
+)
+{
+    std::vector<Edge<V, W>> buffer(count);
+    sortEdges(edges, count, buffer.data());
+}
+
+template<typename V, typename O, typename W, typename EdgeWeightFunction>
+size_t getSortedEdges(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    Edge<V, W> * edges,//[offsets[vertex_count]]
+    EdgeWeightFunction e//e(V, V)
+)
+{
+    size_t const count = getEdges(vertex_count, offsets, adjacency, edges, e);
+    sortEdges(edges, count);
+    return count;
+}
@@ -0,0 +1,168 @@
+#ifndef CONNECTED_COMPONENT_TREE_GRAPH_BUILDER_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_GRAPH_BUILDER_H_INCLUDED
+
+#include "cct/graph.h"
+#include "cct/array_storage.h"
+#include "cct/array_tree.h"
+#include "cct/root_finder.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+namespace graph {
+
+/** \brief Kruskal-like alpha-tree construction from sorted graph edges.
+ *
+ * Vertices are leaves, so they must be in [0, leaf_count[.
+ * root must contain leaf_count singletons with data = leaf index.
+ */
+template<
+    typename V, typename I, typename S, typename Weight
+>
+void buildAlphaTree(
+    Edge<V, Weight> const * edges, size_t edge_count,
+    array_tree<I, S, Weight> & tree,
+    cct::PackedRootFinder<S, I> & root,
+    I * merges//[max(leaf_count, node_capacity-leaf_count+1)]
+)
+{
+    if(edge_count == 0)
+        return;
+
+    Weight weight = edges[0].weight;
+    S layer_begin = tree.node_count;
+    for(size_t i = 0; i < edge_count; ++i)
+    {
+        BOOST_ASSERT(I(edges[i].vertices[0]) < tree.leaf_count);
+        BOOST_ASSERT(I(edges[i].vertices[1]) < tree.leaf_count);
+        if(edges[i].weight > weight)
+        {
+            weight = edges[i].weight;
+            layer_begin = tree.node_count;
+        }
+        I const ha = root.find_update(edges[i].vertices[0]);
+        I const hb = root.find_update(edges[i].vertices[1]);
+        if(ha != hb)
+        {
+            root.merge_set(ha, hb,
+                tree.alpha_merge(root.data(ha), root.data(hb), layer_begin, edges[i].weight, merges)
+            );
+        }
+    }
+    tree.finish_alpha_merges(merges);
+    tree.compress(merges);
+}
+
+/** \brief Alpha-tree of graph given by edge list.
+ *
+ * Edges are sorted in place, tree.leaf_count is the vertex count.
+ */
+template<
+    typename V, typename I, typename S, typename Weight
+>
+void buildAlphaTree(
+    Edge<V, Weight> * edges, size_t edge_count,
+    array_tree<I, S, Weight> & tree
+)
+{
+    sortEdges(edges, edge_count);
+
+    cct::PackedRootFinder<S, I> root(tree.leaf_count, cct::LeafIndexTag());
+
+    std::unique_ptr<I[]> merges(new I[std::max<size_t>(tree.leaf_count, tree.node_capacity-tree.leaf_count+1)]);
+
+    buildAlphaTree(edges, edge_count, tree, root, merges.get());
+}
+
+/** \brief Build alpha-tree of graph given by edge list into reusable storage. */
+template<
+    typename V, typename I, typename S, typename Weight
+>
+array_tree<I, S, Weight> & buildAlphaTree(
+    V vertex_count,
+    Edge<V, Weight> * edges, size_t edge_count,
+    array_tree_storage<I, S, Weight> & storage
+)
+{
+    array_tree<I, S, Weight> & tree = storage.init(vertex_count);
+
+    sortEdges(edges, edge_count, storage.template buffer<Edge<V, Weight>>(edge_count));
+
+    storage.root_finder().init(vertex_count, cct::LeafIndexTag());
+
+    buildAlphaTree(edges, edge_count, tree, storage.root_finder(), storage.merges());
+    return tree;
+}
+
+/** \brief Alpha-tree of graph in compressed sparse row form.
+ *
+ * See getEdges for the layout, tree.leaf_count is the vertex count.
+ */
+template<
+    typename V, typename O, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction
+>
+void buildAlphaTree(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    array_tree<I, S, Weight> & tree,
+    EdgeWeightFunction e//e(V, V)
+)
+{
+    typedef Edge<V, Weight> Edge;
+
+    BOOST_ASSERT(I(vertex_count) == tree.leaf_count);
+
+    std::vector<Edge> edges(offsets[vertex_count]);
+    size_t const edge_count = getSortedEdges(vertex_count, offsets, adjacency, edges.data(), e);
+
+    cct::PackedRootFinder<S, I> root(tree.leaf_count, cct::LeafIndexTag());
+
+    std::unique_ptr<I[]> merges(new I[std::max<size_t>(tree.leaf_count, tree.node_capacity-tree.leaf_count+1)]);
+
+    buildAlphaTree(edges.data(), edge_count, tree, root, merges.get());
+}
+
+/** \brief Build alpha-tree of graph in compressed sparse row form into reusable storage. */
+template<
+    typename V, typename O, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction
+>
+array_tree<I, S, Weight> & buildAlphaTree(
+    V vertex_count,
+    O const * offsets,//[vertex_count+1]
+    V const * adjacency,//[offsets[vertex_count]]
+    array_tree_storage<I, S, Weight> & storage,
+    EdgeWeightFunction e//e(V, V)
+)
+{
+    typedef Edge<V, Weight> Edge;
+
+    array_tree<I, S, Weight> & tree = storage.init(vertex_count);
+
+    // edges and radix sort buffer, symmetric lists give at most capacity/2 edges
+    size_t const capacity = offsets[vertex_count];
+    Edge * edges = storage.template buffer<Edge>(capacity);
+    size_t const edge_count = getEdges(vertex_count, offsets, adjacency, edges, e);
+    if(2*edge_count <= capacity)
+        sortEdges(edges, edge_count, edges + edge_count);
+    else
+        sortEdges(edges, edge_count);
+
+    storage.root_finder().init(vertex_count, cct::LeafIndexTag());
+
+    buildAlphaTree(edges, edge_count, tree, storage.root_finder(), storage.merges());
+    return tree;
+}
+
+}//namespace graph
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_GRAPH_BUILDER_H_INCLUDED
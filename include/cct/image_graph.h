@@ -4,6 +4,7 @@
 #include "utils/fp.h"
 
 #include <array>
+#include <tuple>
 
 #include <boost/optional.hpp>
 
@@ -182,7 +183,11 @@ size_t getSortedPixelEdges(
     EdgeWeightFunction e//f(cv::Point)
 );
 */
-/*
+/** \brief Extracts image vertices and edges
+ *
+ * Weight functions return optional weights, elements without weight are skipped.
+ * \returns (vertex count, edge count)
+ */
 template<typename T,
     typename VertexType, typename EdgeType,
     typename VertexWeightFunction, typename EdgeWeightFunction
@@ -191,10 +196,28 @@ std::tuple<size_t, size_t> getImageGraph(
         cv::Rect_<T> const & rect,
         VertexType * vertices,//[vertexCount(rect.size())]
         EdgeType   * edges,   //[edgeCount  (rect.size())]
-        VertexWeightFunction v,//f(cv::Point) -> boost::optional<???>
-        EdgeWeightFunction   e //f(cv::Point, cv::Point) -> boost::optional<???>
+        VertexWeightFunction v,//f(cv::Point) -> boost::optional<weight>
+        EdgeWeightFunction   e //f(cv::Point, cv::Point) -> boost::optional<weight>
         );
-*/
+
+/** \brief Extracts image vertices and sorts them
+ *
+ * Depending on vertex weight :
+ *  uint8_t - counting sort, 2 image passes
+ *  other - std::sort + 1 image pass
+ */
+template<typename T, typename W, typename VertexWeightFunction>
+size_t getSortedImageVertices(
+    cv::Rect_<T> const & rect,
+    Vertex<T, W> * vertices,//[vertexCount(rect.size())]
+    VertexWeightFunction v//f(cv::Point)
+);
+template<typename T, typename VertexWeightFunction>
+size_t getSortedImageVertices(
+    cv::Rect_<T> const & rect,
+    Vertex<T, uint8_t> * vertices,//[vertexCount(rect.size())]
+    VertexWeightFunction v//f(cv::Point)
+);
 
 /* \brief Extract horizontal edges connecting tiles.
  */
@@ -252,6 +275,36 @@ size_t getSortedVerticalConnectors(
     EdgeWeightFilter f = EdgeWeightFilter()
 );
 
+/* \brief Extract temporal edges connecting pixels of two frames.
+ *
+ * Both points of an edge are the same pixel, points[0] is in the previous frame.
+ */
+template<typename T, typename W, typename EdgeWeightFunction, typename EdgeWeightFilter = utils::fp::constant_true>
+size_t getTemporalConnectors(
+    cv::Rect_<T> const & rect,
+    Edge<T, W> * edges,//[rect.area()]
+    EdgeWeightFunction e,//e(cv::Point)
+    EdgeWeightFilter f = EdgeWeightFilter()
+);
+
+/* \brief Extract temporal edges connecting pixels of two frames and sort them.
+ */
+template<typename T, typename W, typename EdgeWeightFunction, typename EdgeWeightFilter = utils::fp::constant_true>
+size_t getSortedTemporalConnectors(
+    cv::Rect_<T> const & rect,
+    Edge<T, W> * edges,//[rect.area()]
+    EdgeWeightFunction e,//e(cv::Point)
+    EdgeWeightFilter f = EdgeWeightFilter()
+);
+
+template<typename T, typename EdgeWeightFunction, typename EdgeWeightFilter = utils::fp::constant_true>
+size_t getSortedTemporalConnectors(
+    cv::Rect_<T> const & rect,
+    Edge<T, uint8_t> * edges,//[rect.area()]
+    EdgeWeightFunction e,//e(cv::Point)
+    EdgeWeightFilter f = EdgeWeightFilter()
+);
+
 #if 0
 /**
  * Dummy predicate for disabling the tests.
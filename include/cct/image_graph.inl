@@ -264,6 +264,75 @@ size_t getSortedImageEdges(
     return edge_count;
 }
 
+template<typename T, typename W, typename VertexWeightFunction>
+size_t getSortedImageVertices(
+    cv::Rect_<T> const & rect,
+    Vertex<T, W> * vertices,//[vertexCount(rect.size())]
+    VertexWeightFunction v//f(cv::Point)
+)
+{
+    typedef cv::Point_<T> Point;
+    // preconditions
+    BOOST_ASSERT(rect.width  >= 0);
+    BOOST_ASSERT(rect.height >= 0);
+    BOOST_ASSERT(vertices);
+    // extract vertices
+    size_t count = 0;
+    for(T y = rect.y; y < rect.y+rect.height; ++y)
+    {
+        for(T x = rect.x; x < rect.x+rect.width; ++x)
+        {
+            Vertex<T, W> & vertex = vertices[count++];
+            vertex.point = Point(x, y);
+            vertex.weight = v(vertex.point);
+        }
+    }
+    // sort them
+    std::sort(vertices, vertices + count);
+    return count;
+}
+
+template<typename T, typename VertexWeightFunction>
+size_t getSortedImageVertices(
+    cv::Rect_<T> const & rect,
+    Vertex<T, uint8_t> * vertices,//[vertexCount(rect.size())]
+    VertexWeightFunction v//f(cv::Point)
+)
+{
+    typedef cv::Point_<T> Point;
+    // preconditions
+    BOOST_ASSERT(rect.width  >= 0);
+    BOOST_ASSERT(rect.height >= 0);
+    BOOST_ASSERT(vertices);
+    // build histogram
+    unsigned histogram[256];
+    memset(histogram, 0, sizeof(histogram));
+    for(T y = rect.y; y < rect.y+rect.height; ++y)
+    {
+        for(T x = rect.x; x < rect.x+rect.width; ++x)
+        {
+            ++histogram[v(Point(x, y))];
+        }
+    }
+    // get indices by prefix sum
+    unsigned indices[257];
+    indices[0] = 0;
+    std::partial_sum(histogram, histogram + 256, indices + 1);
+    // extract vertices
+    for(T y = rect.y; y < rect.y+rect.height; ++y)
+    {
+        for(T x = rect.x; x < rect.x+rect.width; ++x)
+        {
+            uint8_t w = v(Point(x, y));
+            Vertex<T, uint8_t> & vertex = vertices[indices[w]++];
+            vertex.point = Point(x, y);
+            vertex.weight = w;
+        }
+    }
+    BOOST_ASSERT(indices[255] == indices[256]);
+    return indices[256];
+}
+
 template<typename T,
     typename VertexType, typename EdgeType,
     typename VertexWeightFunction, typename EdgeWeightFunction
@@ -462,3 +531,91 @@ size_t getSortedVerticalConnectors(
     BOOST_ASSERT(indices[255] == indices[256]);
     return indices[256];
 }
+
+template<typename T, typename W, typename EdgeWeightFunction, typename EdgeWeightFilter>
+size_t getTemporalConnectors(
+        cv::Rect_<T> const & rect,
+        Edge<T, W> * edges,//[rect.area()]
+        EdgeWeightFunction e,//f(cv::Point)
+        EdgeWeightFilter f
+        )
+{
+    typedef cv::Point_<T> Point;
+    typedef Edge<T, W> Edge;
+
+    size_t count = 0;
+    for(T y = rect.y; y < rect.y+rect.height; ++y)
+    {
+        for(T x = rect.x; x < rect.x+rect.width; ++x)
+        {
+            Point a(x, y);
+            W w = e(a);
+            if(f(w))
+            {
+                Edge & edge = edges[count++];
+                edge.points[0] = a;
+                edge.points[1] = a;
+                edge.weight = w;
+            }
+        }
+    }
+    return count;
+}
+
+template<typename T, typename W, typename EdgeWeightFunction, typename EdgeWeightFilter>
+size_t getSortedTemporalConnectors(
+        cv::Rect_<T> const & rect,
+        Edge<T, W> * edges,
+        EdgeWeightFunction e,
+        EdgeWeightFilter f
+        )
+{
+    size_t const count = getTemporalConnectors(rect, edges, e, f);
+    std::sort(edges, edges+count);
+    return count;
+}
+
+template<typename T, typename EdgeWeightFunction, typename EdgeWeightFilter>
+size_t getSortedTemporalConnectors(
+    cv::Rect_<T> const & rect,
+    Edge<T, uint8_t> * edges,//[rect.area()]
+    EdgeWeightFunction e,//f(cv::Point)
+    EdgeWeightFilter f
+)
+{
+    typedef cv::Point_<T> Point;
+    typedef Edge<T, uint8_t> Edge;
+    // build histogram, frame may have more than 2^32 pixels
+    size_t histogram[256];
+    std::fill_n(histogram, 256, 0);
+    for(T y = rect.y; y < rect.y+rect.height; ++y)
+    {
+        for(T x = rect.x; x < rect.x+rect.width; ++x)
+        {
+            uint8_t w = e(Point(x, y));
+            if(f(w))
+                ++histogram[w];
+        }
+    }
+    size_t indices[257];
+    indices[0] = 0;
+    std::partial_sum(histogram, histogram + 256, indices + 1);
+    // extract edges
+    for(T y = rect.y; y < rect.y+rect.height; ++y)
+    {
+        for(T x = rect.x; x < rect.x+rect.width; ++x)
+        {
+            Point a(x, y);
+            uint8_t w = e(a);
+            if(f(w))
+            {
+                Edge & edge = edges[indices[w]++];
+                edge.points[0] = a;
+                edge.points[1] = a;
+                edge.weight = w;
+            }
+        }
+    }
+    BOOST_ASSERT(indices[255] == indices[256]);
+    return indices[256];
+}
@@ -0,0 +1,371 @@
+#ifndef CONNECTED_COMPONENT_TREE_IMAGE_MAXTREE_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_IMAGE_MAXTREE_H_INCLUDED
+
+#include "cct/array_tree.h"
+#include "cct/root_finder.h"
+
+#include "utils/parallel.h"
+
+#include <cstdint>
+
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <opencv2/core/core.hpp>
+
+namespace cct {
+
+namespace image {
+
+/** \brief Counting sort of pixel ids of rows [y_begin, y_end[ by value.
+ *
+ * Ids are relative to the first pixel of y_begin.
+ */
+template<typename V, typename I>
+void getSortedPixels(
+    V const * values,//[(y_end-y_begin)*width] first pixel of y_begin
+    I count,
+    I * pixels,//[count]
+    size_t * offsets//[max(V)+2]
+)
+{
+    size_t const bins = size_t(std::numeric_limits<V>::max())+1;
+    std::fill_n(offsets, bins+1, 0);
+    for(I i = 0; i < count; ++i)
+    {
+        ++offsets[values[i]+1];
+    }
+    std::partial_sum(offsets, offsets+bins+1, offsets);
+    for(I i = 0; i < count; ++i)
+    {
+        pixels[offsets[values[i]]++] = i;
+    }
+}
+
+/** \brief Level set tree of a strip of rows, as pixel parents.
+ *
+ * Berger's union-find over counting sorted pixels.
+ * Pixels are processed from top level (max for max-tree) to bottom,
+ * the representative of each zpar set is the last processed pixel.
+ * parents are canonical :
+ *  parents[p] == p - root
+ *  value(parents[p]) == value(p) - parents[p] is the canonical element of the zone
+ *  otherwise - p is canonical, parents[p] is canonical element of its parent
+ */
+template<typename V, typename I>
+void buildLevelSetParents(
+    V const * values,//[width*height] whole image
+    I width, I y_begin, I y_end,
+    bool max_tree,
+    I * parents//[width*height] global pixel ids
+)
+{
+    I const begin = y_begin*width;
+    I const count = (y_end-y_begin)*width;
+    V const * v = values + begin;
+    I * par = parents + begin;
+
+    std::vector<I> pixels(count);
+    std::vector<size_t> offsets(size_t(std::numeric_limits<V>::max())+2);
+    getSortedPixels(v, count, pixels.data(), offsets.data());
+
+    cct::PackedRootFinder<I, I> zpar(count, cct::LeafIndexTag());
+    std::vector<bool> done(count, false);
+
+    auto link = [&](I p, I q)
+        {
+            if(!done[q])
+                return;
+            I const hp = zpar.find_update(p);
+            I const hq = zpar.find_update(q);
+            if(hp != hq)
+            {
+                par[zpar.data(hq)] = p + begin;
+                zpar.merge_set(hp, hq, p);
+            }
+        };
+
+    for(I k = 0; k < count; ++k)
+    {
+        I const p = max_tree ? pixels[count-1-k] : pixels[k];
+        par[p] = p + begin;
+        done[p] = true;
+        I const x = p % width;
+        if(x > 0)
+            link(p, p-1);
+        if(x+1 < width)
+            link(p, p+1);
+        if(p >= width)
+            link(p, p-width);
+        if(p+width < count)
+            link(p, p+width);
+    }
+    // canonize from root to leaves
+    for(I k = count; k-- > 0;)
+    {
+        I const p = max_tree ? pixels[count-1-k] : pixels[k];
+        I const q = par[p];
+        if(values[parents[q]] == values[q])
+            par[p] = parents[q];
+    }
+}
+
+/** \brief Canonical element of the zone of p (Wilkinson's levroot). */
+template<typename V, typename I>
+inline I levelRoot(V const * values, I const * parents, I p)
+{
+    while((parents[p] != p) && (values[parents[p]] == values[p]))
+        p = parents[p];
+    return p;
+}
+
+/** \brief Merge level set trees of two neighbouring pixels.
+ *
+ * Wilkinson's connect, ancestors of both pixels are merged into one branch.
+ * Canonical form of parents is not kept.
+ */
+template<typename V, typename I>
+void connectLevelSetParents(
+    V const * values,
+    I * parents,
+    bool max_tree,
+    I x, I y
+)
+{
+    // a is above b in the tree
+    auto above = [&](I a, I b)
+        {
+            return max_tree ? (values[a] > values[b]) : (values[a] < values[b]);
+        };
+    x = levelRoot(values, parents, x);
+    y = levelRoot(values, parents, y);
+    if(above(y, x))
+        std::swap(x, y);
+    // values[x] is on or above values[y]
+    while(x != y)
+    {
+        if(parents[x] == x)
+        {
+            // x is root, attach it
+            parents[x] = y;
+            return;
+        }
+        I const z = levelRoot(values, parents, parents[x]);
+        if(!above(y, z))
+        {
+            // z is still on or above y
+            x = z;
+        }
+        else
+        {
+            parents[x] = y;
+            x = y;
+            y = z;
+        }
+    }
+}
+
+/** \brief Convert pixel parents to array_tree.
+ *
+ * Zone with single pixel and no child zones is just a leaf,
+ * other zones become components.
+ * Components are ordered from top level to bottom, so parents[i]+lc > i.
+ */
+template<typename V, typename I, typename S, typename L>
+void levelSetParentsToTree(
+    V const * values,
+    I const * pixel_parents,//[leaf_count] from buildLevelSetParents / connectLevelSetParents
+    bool max_tree,
+    array_tree<I, S, L> & tree,
+    unsigned threads = 1
+)
+{
+    BOOST_ASSERT(tree.leaf_levels);
+    I const lc = tree.leaf_count;
+    I const root = tree.node_capacity-lc;
+    I const none = std::numeric_limits<I>::max();
+
+    tree.reset();
+
+    // canonical elements of zones
+    std::vector<I> zones(lc);
+    utils::parallelFor(0, lc, threads,
+        [&](size_t begin, size_t end)
+        {
+            for(I p = begin; p < end; ++p)
+            {
+                zones[p] = levelRoot(values, pixel_parents, p);
+                tree.leaf_levels[p] = values[p];
+            }
+        }
+    );
+    // zone of parent for canonical elements
+    auto parent_zone = [&](I c) -> I
+        {
+            return (pixel_parents[c] == c) ? none : zones[pixel_parents[c]];
+        };
+    // count pixels and child zones
+    std::vector<I> counts(lc, 0);
+    for(I p = 0; p < lc; ++p)
+    {
+        ++counts[zones[p]];
+        if(zones[p] == p)
+        {
+            I const z = parent_zone(p);
+            if(z != none)
+                ++counts[z];
+        }
+    }
+    // order components by level, top level first
+    size_t const bins = size_t(std::numeric_limits<V>::max())+1;
+    std::vector<size_t> offsets(bins+1, 0);
+    for(I p = 0; p < lc; ++p)
+    {
+        if((zones[p] == p) && (counts[p] > 1))
+        {
+            size_t const bin = max_tree ? (bins-1-values[p]) : values[p];
+            ++offsets[bin+1];
+        }
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    size_t const comp_count = offsets[bins];
+    BOOST_ASSERT(lc + comp_count <= tree.node_capacity);
+    // counts now hold comp indices
+    for(I p = 0; p < lc; ++p)
+    {
+        if(zones[p] == p)
+        {
+            if(counts[p] > 1)
+            {
+                size_t const bin = max_tree ? (bins-1-values[p]) : values[p];
+                counts[p] = offsets[bin]++;
+            }
+            else
+            {
+                counts[p] = none;
+            }
+        }
+    }
+
+    tree.node_count = lc + comp_count;
+    for(I p = 0; p < lc; ++p)
+    {
+        I const c = counts[zones[p]];
+        if(c != none)
+        {
+            tree.parents[p] = c;
+            if(zones[p] == p)
+            {
+                I const z = parent_zone(p);
+                tree.parents[c+lc] = (z == none) ? root : counts[z];
+                tree.comp_levels[c] = values[p];
+            }
+        }
+        else
+        {
+            // single pixel zone without children
+            I const z = parent_zone(p);
+            tree.parents[p] = (z == none) ? root : counts[z];
+        }
+    }
+}
+
+/** \brief Level set tree construction (max-tree / min-tree).
+ *
+ * Rows are split into strips, level set tree of each strip is built in parallel.
+ * Strips are merged along seams by Wilkinson's connect.
+ */
+template<typename V, typename I, typename S, typename L>
+void buildLevelSetTree(
+    cv::Mat const & image,
+    array_tree<I, S, L> & tree,
+    bool max_tree,
+    unsigned threads = 1
+)
+{
+    BOOST_ASSERT(image.channels() == 1);
+    BOOST_ASSERT(image.isContinuous());
+    BOOST_ASSERT(I(image.cols)*I(image.rows) == tree.leaf_count);
+
+    I const width = image.cols;
+    V const * values = image.ptr<V>(0);
+
+    std::vector<I> parents(tree.leaf_count);
+    // first rows of strips
+    std::vector<I> seams;
+    boost::mutex mutex;
+    utils::parallelFor(0, image.rows, threads,
+        [&](size_t begin, size_t end)
+        {
+            buildLevelSetParents<V, I>(values, width, begin, end, max_tree, parents.data());
+            boost::mutex::scoped_lock lock(mutex);
+            seams.push_back(begin);
+        }
+    );
+    for(I y : seams)
+    {
+        if(y == 0)
+            continue;
+        for(I x = 0; x < width; ++x)
+        {
+            connectLevelSetParents(values, parents.data(), max_tree, (y-1)*width+x, y*width+x);
+        }
+    }
+    levelSetParentsToTree(values, parents.data(), max_tree, tree, threads);
+}
+
+/** \brief Max-tree of CV_8UC1 or CV_16UC1 image.
+ *
+ * Leaves are pixels with leaf_levels set to pixel values,
+ * components are nonsingleton peak components with their gray level.
+ */
+template<typename I, typename S, typename L>
+void buildMaxTree(
+    cv::Mat const & image,
+    array_tree<I, S, L> & tree,
+    unsigned threads = 1
+)
+{
+    switch(image.depth())
+    {
+    case CV_8U :
+        buildLevelSetTree<uint8_t>(image, tree, true, threads);
+        break;
+    case CV_16U :
+        buildLevelSetTree<uint16_t>(image, tree, true, threads);
+        break;
+    default :
+        BOOST_ASSERT(!"Unsupported pixel type");
+    }
+}
+
+/** \brief Min-tree of CV_8UC1 or CV_16UC1 image. */
+template<typename I, typename S, typename L>
+void buildMinTree(
+    cv::Mat const & image,
+    array_tree<I, S, L> & tree,
+    unsigned threads = 1
+)
+{
+    switch(image.depth())
+    {
+    case CV_8U :
+        buildLevelSetTree<uint8_t>(image, tree, false, threads);
+        break;
+    case CV_16U :
+        buildLevelSetTree<uint16_t>(image, tree, false, threads);
+        break;
+    default :
+        BOOST_ASSERT(!"Unsupported pixel type");
+    }
+}
+
+}//namespace image
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_IMAGE_MAXTREE_H_INCLUDED
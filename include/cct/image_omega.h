@@ -0,0 +1,234 @@
+#ifndef CONNECTED_COMPONENT_TREE_IMAGE_OMEGA_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_IMAGE_OMEGA_H_INCLUDED
+
+#include "cct/array_builder.h"
+#include "cct/image_graph.h"
+#include "cct/image_tree.h"
+#include "cct/root_finder.h"
+
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+namespace image {
+
+/** \brief Value range of a component for the omega constraint. */
+template<typename Value>
+struct OmegaRange
+{
+    Value min;
+    Value max;
+    // component can't grow without breaking the constraint
+    bool frozen;
+
+    OmegaRange()
+        : min(), max(), frozen(false)
+    {}
+
+    explicit OmegaRange(Value v)
+        : min(v), max(v), frozen(false)
+    {}
+
+    void merge(OmegaRange const & r)
+    {
+        min = std::min(min, r.min);
+        max = std::max(max, r.max);
+        frozen = frozen || r.frozen;
+    }
+};
+
+/** \brief Keep only edges of alpha-omega constrained connectivity.
+ *
+ * An edge of weight alpha is kept, if the alpha-connected component
+ * (of already kept edges + all edges of weight alpha) containing it
+ * has range (max-min of v) <= omega and no frozen part.
+ * Components of dropped edges are frozen, since every bigger component
+ * contains them and breaks the constraint as well.
+ * Any alpha-tree built from the kept edges is the alpha-omega hierarchy.
+ *
+ * Every level is processed twice :
+ *  1. level union-find groups roots connected by the level edges, merging ranges
+ *  2. edges of valid groups are kept and merged, roots of invalid groups are frozen
+ * O(edge_count*alpha(vertex_count))
+ *
+ * Edges must be sorted by weight, kept edges are moved to the front in the same order.
+ * \returns kept edge count
+ */
+template<
+    typename T, typename W,
+    typename VertexWeightFunction,
+    typename Omega
+>
+size_t getOmegaEdges(
+    cv::Size_<T> const & size,
+    Edge<T, W> * edges, size_t edge_count,
+    VertexWeightFunction v,//v(cv::Point) -> value
+    Omega omega
+)
+{
+    typedef cv::Point_<T> Point;
+    typedef decltype(v(Point())) Value;
+    typedef OmegaRange<Value> Range;
+    typedef cct::PackedRootFinder<Range, size_t> RootFinder;
+
+    size_t const vertex_count = size_t(size.width)*size_t(size.height);
+
+    // committed merges, data of roots are their ranges
+    RootFinder root(vertex_count, Range());
+    for(T y = 0; y < size.height; ++y)
+    {
+        for(T x = 0; x < size.width; ++x)
+        {
+            root.data(pointId<size_t>(Point(x, y), size)) = Range(v(Point(x, y)));
+        }
+    }
+    // level merges, entries are valid only if stamp is the current level
+    RootFinder level(vertex_count, Range());
+    std::vector<size_t> stamps(vertex_count, 0);
+    size_t stamp = 0;
+
+    auto level_find = [&](size_t h) -> size_t
+        {
+            if(stamps[h] != stamp)
+            {
+                stamps[h] = stamp;
+                level.resetRange(h, h+1, root.data(h));
+                return h;
+            }
+            return level.find_update(h);
+        };
+
+    size_t kept = 0;
+    size_t begin = 0;
+    while(begin < edge_count)
+    {
+        size_t end = begin+1;
+        while((end < edge_count) && !(edges[begin].weight < edges[end].weight))
+            ++end;
+        ++stamp;
+        // group roots by level edges
+        for(size_t i = begin; i < end; ++i)
+        {
+            size_t const ha = root.find_update(pointId<size_t>(edges[i].points[0], size));
+            size_t const hb = root.find_update(pointId<size_t>(edges[i].points[1], size));
+            if(ha != hb)
+            {
+                size_t const la = level_find(ha);
+                size_t const lb = level_find(hb);
+                if(la != lb)
+                {
+                    Range r = level.data(la);
+                    r.merge(level.data(lb));
+                    level.merge_set(la, lb, r);
+                }
+            }
+        }
+        // keep edges of valid groups
+        for(size_t i = begin; i < end; ++i)
+        {
+            size_t const ha = root.find_update(pointId<size_t>(edges[i].points[0], size));
+            size_t const hb = root.find_update(pointId<size_t>(edges[i].points[1], size));
+            if(ha != hb)
+            {
+                Range const & group = level.data(level_find(ha));
+                if(!group.frozen && !(Omega(group.max - group.min) > omega))
+                {
+                    Range r = root.data(ha);
+                    r.merge(root.data(hb));
+                    root.merge_set(ha, hb, r);
+                    edges[kept++] = edges[i];
+                }
+                else
+                {
+                    root.data(ha).frozen = true;
+                    root.data(hb).frozen = true;
+                }
+            }
+        }
+        begin = end;
+    }
+    return kept;
+}
+
+/** \brief Alpha-omega tree construction for array_tree.
+ *
+ * Components are (alpha, omega)-connected components at level alpha.
+ * Result is a forest, once a component breaks the omega constraint it stays a root.
+ */
+template<
+    typename T, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction,
+    typename VertexWeightFunction,
+    typename Omega
+>
+void buildAlphaOmegaTree(
+    cv::Size_<T> const & size, cv::Size_<T> const & tile,
+    array_tree<I, S, Weight> & tree,
+    EdgeWeightFunction e,
+    VertexWeightFunction v,
+    Omega omega
+)
+{
+    typedef Edge<T, Weight> Edge;
+
+    std::vector<Edge> edges(edgeCount<size_t>(size));
+    size_t edge_count = getSortedImageEdges(
+        cv::Rect_<T>(0, 0, size.width, size.height), tile, edges.data(), e);
+    edge_count = getOmegaEdges(size, edges.data(), edge_count, v, omega);
+
+    cct::PackedRootFinder<S, I> root(vertexCount<I>(size), cct::LeafIndexTag());
+
+    std::unique_ptr<I[]> merges(new I[std::max<size_t>(tree.leaf_count, tree.node_capacity-tree.leaf_count+1)]);
+
+    buildAlphaTree(size, edges.data(), edge_count, tree, root, merges.get());
+}
+
+/** \brief Alpha-omega tree construction for pointer trees. */
+template<
+    typename T,
+    typename Builder,
+    typename EdgeWeightFunction,
+    typename VertexWeightFunction,
+    typename Omega
+>
+void buildAlphaOmegaTree(
+    cv::Size_<T> const & size, cv::Size_<T> const & tile,
+    Builder & builder,
+    EdgeWeightFunction e,
+    VertexWeightFunction v,
+    Omega omega
+)
+{
+    typedef cv::Point_<T> Point;
+    typedef decltype(e(Point(),Point())) Weight;
+    typedef Edge<T, Weight> Edge;
+
+    std::vector<Edge> edges(edgeCount(size));
+    size_t count = getSortedImageEdges(
+        cv::Rect_<T>(0, 0, size.width, size.height), tile, edges.data(), e);
+    count = getOmegaEdges(size, edges.data(), count, v, omega);
+
+    ThreadBuilder<Builder> thread_builder(builder);
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        if((i > 0) && (edges[i-1].weight < edges[i].weight))
+        {
+            thread_builder.remove();
+        }
+        thread_builder.addEdge(
+            pointId(edges[i].points[0], size),
+            pointId(edges[i].points[1], size),
+            edges[i]
+        );
+    }
+    builder.finish(std::move(thread_builder));
+}
+
+}//namespace image
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_IMAGE_OMEGA_H_INCLUDED
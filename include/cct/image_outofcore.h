@@ -0,0 +1,410 @@
+#ifndef CONNECTED_COMPONENT_TREE_IMAGE_OUTOFCORE_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_IMAGE_OUTOFCORE_H_INCLUDED
+
+#include "cct/array_boundary.h"
+#include "cct/array_builder.h"
+#include "cct/array_io.h"
+#include "cct/array_storage.h"
+#include "cct/image_tree.h"
+
+#include <cmath>
+#include <cstdint>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+namespace image {
+
+/** \brief Rectangles of a raw image file.
+ *
+ * Pixels are stored row by row without padding, only requested rows are read.
+ */
+class RawImageSource
+{
+    std::ifstream m_file;
+    cv::Size m_size;
+    int m_type;
+    size_t m_pixel_size;
+public :
+    /** \throws std::runtime_error if the file can not be opened */
+    RawImageSource(std::string const & filename, cv::Size const & size, int type)
+        : m_file(filename.c_str(), std::ios::binary), m_size(size), m_type(type)
+        , m_pixel_size(cv::Mat(1, 1, type).elemSize())
+    {
+        if(!m_file)
+            throw std::runtime_error("can not open " + filename);
+    }
+
+    cv::Size size() const
+    {
+        return m_size;
+    }
+
+    size_t pixelSize() const
+    {
+        return m_pixel_size;
+    }
+
+    /** \throws std::runtime_error on read errors */
+    cv::Mat read(cv::Rect const & rect)
+    {
+        cv::Mat image(rect.height, rect.width, m_type);
+        for(int y = 0; y < rect.height; ++y)
+        {
+            m_file.seekg((uint64_t(rect.y+y)*m_size.width + rect.x)*m_pixel_size);
+            m_file.read(reinterpret_cast<char *>(image.ptr(y)), rect.width*m_pixel_size);
+        }
+        if(!m_file)
+            throw std::runtime_error("raw image read failed");
+        return image;
+    }
+};
+
+/** \brief Rectangles of an image in memory, e.g. cv::Mat over a memory mapped file.
+ *
+ * Rectangles are views, no pixels are copied.
+ */
+class MatImageSource
+{
+    cv::Mat m_image;
+public :
+    explicit MatImageSource(cv::Mat const & image)
+        : m_image(image)
+    {}
+
+    cv::Size size() const
+    {
+        return m_image.size();
+    }
+
+    size_t pixelSize() const
+    {
+        return m_image.elemSize();
+    }
+
+    cv::Mat read(cv::Rect const & rect)
+    {
+        return m_image(rect);
+    }
+};
+
+/** \brief Tree of a tiled image, stored on disk.
+ *
+ * Every tile tree is in its own file (see writeTree),
+ * changes made by merging tiles are in corrections.
+ * Node ids are global, see global_id.
+ */
+template<typename I, typename S, typename L>
+struct tiled_tree
+{
+    typedef array_tree<I, S, L> tree_type;
+    typedef L level_type;
+
+    cv::Size size;
+    cv::Size grid;
+    std::string directory;
+
+    // first component id of tile i + j*grid.width
+    std::vector<global_id> offsets;
+    // all component ids are smaller
+    global_id id_count;
+
+    boundary_corrections<L> corrections;
+
+    size_t tileCount() const
+    {
+        return size_t(grid.width)*grid.height;
+    }
+
+    cv::Rect tileRect(size_t k) const
+    {
+        return gridRect(size, grid, cv::Rect(int(k % grid.width), int(k / grid.width), 1, 1));
+    }
+
+    std::string tileFile(size_t k) const
+    {
+        return directory + "/tile-" + std::to_string(k) + ".cct";
+    }
+};
+
+/** \brief Bytes needed for building a tree of one tile, per pixel. */
+template<typename I, typename S, typename L>
+size_t outOfCoreBytesPerPixel(size_t pixel_size)
+{
+    // edges, tree storage with merges, root finder, pixels
+    return 2*sizeof(Edge<int, L>)
+        + 2*(sizeof(I) + sizeof(L) + 2*sizeof(S)) + sizeof(I)
+        + sizeof(S) + sizeof(I)
+        + pixel_size;
+}
+
+/** \brief Bytes of corrections per border pixel of a tile.
+ *
+ * A border pixel brings at most a leaf parent, a boundary component with its parent and alias,
+ * and a component created by a merge with its parent.
+ */
+template<typename L>
+size_t outOfCoreCorrectionBytesPerPixel()
+{
+    // hash map node with key, value, next pointer and its bucket
+    size_t const entry = 2*sizeof(global_id) + 2*sizeof(void *);
+    // components vector grows by doubling
+    return 4*entry + 2*sizeof(std::pair<global_id, L>);
+}
+
+/** \brief Tile grid for building within memory_budget bytes.
+ *
+ * Building one tile takes half of the budget, the rest is left for boundary trees and corrections.
+ * Corrections grow with the borders of all tiles, if they do not fit beside the tile build,
+ * tiles get larger until both fit.
+ * Tiles have at least 2 pixels.
+ * \throws std::runtime_error if no grid fits into memory_budget
+ */
+template<typename I, typename S, typename L>
+cv::Size outOfCoreGrid(cv::Size const & size, size_t pixel_size, size_t memory_budget)
+{
+    BOOST_ASSERT(size.area() > 1);
+    size_t const tile_bytes = outOfCoreBytesPerPixel<I, S, L>(pixel_size);
+    size_t const border_bytes = outOfCoreCorrectionBytesPerPixel<L>();
+    size_t const pixels = memory_budget/2/tile_bytes;
+    for(int side = std::max(2, int(std::sqrt(double(pixels)))); ; side += side/4 + 1)
+    {
+        int const cols = std::min((size.width  + side-1)/side, std::max(size.width /2, 1));
+        int const rows = std::min((size.height + side-1)/side, std::max(size.height/2, 1));
+        size_t const tile = tile_bytes
+            * size_t((size.width + cols-1)/cols) * size_t((size.height + rows-1)/rows);
+        // borders of all tiles, a single tile is not merged
+        size_t const corrections = (cols*rows == 1) ? 0 :
+            border_bytes * 2*(size_t(cols)*size.height + size_t(rows)*size.width);
+        if(tile + corrections <= memory_budget)
+            return cv::Size(cols, rows);
+        if((cols*rows == 1) || (tile > memory_budget))
+            throw std::runtime_error("memory budget too small for out-of-core build");
+    }
+}
+
+namespace detail {
+
+// Build, spill and merge tiles in cells depth first, only boundary trees stay in memory
+template<
+    typename WeightFunctor,
+    typename I, typename S, typename L,
+    typename Source
+>
+void buildAlphaTreeOutOfCore(
+    Source & source,
+    cv::Size const & tile,
+    tiled_tree<I, S, L> & out,
+    array_tree_storage<I, S, L> & storage,
+    cv::Rect const & cells,
+    boundary_tree<int, L> & boundary
+)
+{
+    typedef Edge<int, L> Edge;
+
+    if((cells.width == 1) && (cells.height == 1))
+    {
+        size_t const k = size_t(cells.x) + size_t(cells.y)*out.grid.width;
+        cv::Rect const rect = out.tileRect(k);
+        cv::Mat const image = source.read(rect);
+        array_tree<I, S, L> & tree = buildAlphaTree(rect.size(), tile, storage, WeightFunctor(image));
+        std::ofstream file(out.tileFile(k).c_str(), std::ios::binary);
+        writeTree(file, tree);
+        out.offsets[k] = out.id_count;
+        out.id_count += tree.node_count - tree.leaf_count;
+        exportBoundaryTree(tree, rect, out.size, out.offsets[k], boundary);
+        return;
+    }
+    // split tiles in halves across the longer side, as buildAlphaTree on a grid
+    cv::Rect const rect = gridRect(out.size, out.grid, cells);
+    cv::Rect ca = cells;
+    cv::Rect cb = cells;
+    if((cells.height == 1) || ((cells.width > 1) && (rect.width > rect.height)))
+    {
+        ca.width = cells.width/2;
+        cb.x += ca.width;
+        cb.width -= ca.width;
+    }
+    else
+    {
+        ca.height = cells.height/2;
+        cb.y += ca.height;
+        cb.height -= ca.height;
+    }
+    boundary_tree<int, L> a;
+    boundary_tree<int, L> b;
+    buildAlphaTreeOutOfCore<WeightFunctor>(source, tile, out, storage, ca, a);
+    buildAlphaTreeOutOfCore<WeightFunctor>(source, tile, out, storage, cb, b);
+    // seam edges from a two pixel strip
+    Seam<int> const seam(gridRect(out.size, out.grid, ca), gridRect(out.size, out.grid, cb));
+    std::vector<Edge> edges(seam.length);
+    size_t count;
+    if(seam.step.y)
+    {
+        cv::Mat const strip = source.read(cv::Rect(seam.a.x, seam.a.y, 2, seam.length));
+        count = getHorizontalConnectors(cv::Point(0, 0), seam.length, edges.data(), WeightFunctor(strip));
+    }
+    else
+    {
+        cv::Mat const strip = source.read(cv::Rect(seam.a.x, seam.a.y, seam.length, 2));
+        count = getVerticalConnectors(cv::Point(0, 0), seam.length, edges.data(), WeightFunctor(strip));
+    }
+    for(size_t i = 0; i < count; ++i)
+    {
+        for(cv::Point & p : edges[i].points)
+        {
+            p.x += seam.a.x;
+            p.y += seam.a.y;
+        }
+    }
+    mergeBoundaryTrees(out.size, a, b, edges.data(), count, out.id_count, boundary, out.corrections);
+}
+
+}//namespace detail
+
+/** \brief Alpha-tree of an image larger than memory.
+ *
+ * Tiles are read from source one by one, their trees are built in reusable storage
+ * and written to directory. Neighbouring tiles are merged by their boundary trees
+ * in the same binary schedule as the grid mode of buildAlphaTree.
+ * Memory holds one tile and O(log tiles) boundary trees, plus corrections
+ * of size O(boundary nodes of all tiles).
+ *
+ * The tree is equivalent to the one of buildAlphaTree,
+ * nodes are available tile by tile through loadTile, or at once through assembleTree.
+ *
+ * Source : size(), pixelSize(), read(rect) -> cv::Mat, see RawImageSource
+ * WeightFunctor : constructed from cv::Mat, edge weights of its pixels
+ * \throws std::runtime_error if memory_budget is too small, see outOfCoreGrid
+ */
+template<
+    typename WeightFunctor,
+    typename I, typename S, typename L,
+    typename Source
+>
+void buildAlphaTreeOutOfCore(
+    Source & source,
+    cv::Size const & tile, // Tile size for tiled image scan, within one tile of the grid
+    size_t memory_budget, // Bytes, decides size of the grid
+    std::string const & directory, // Existing directory for tile trees
+    tiled_tree<I, S, L> & out
+)
+{
+    out.size = source.size();
+    out.grid = outOfCoreGrid<I, S, L>(out.size, source.pixelSize(), memory_budget);
+    out.directory = directory;
+    out.offsets.assign(out.tileCount(), 0);
+    out.id_count = 0;
+    out.corrections = boundary_corrections<L>();
+
+    array_tree_storage<I, S, L> storage;
+    boundary_tree<int, L> boundary;
+    detail::buildAlphaTreeOutOfCore<WeightFunctor>(source, tile, out, storage,
+        cv::Rect(0, 0, out.grid.width, out.grid.height), boundary
+    );
+}
+
+/** \brief Read tree of tile k and final global parents of its nodes.
+ *
+ * parents[tree.node_count] - see correctTile
+ */
+template<typename I, typename S, typename L>
+array_tree<I, S, L> & loadTile(
+    tiled_tree<I, S, L> const & tiled,
+    size_t k,
+    array_tree_storage<I, S, L> & storage,
+    std::vector<global_id> & parents
+)
+{
+    std::ifstream file(tiled.tileFile(k).c_str(), std::ios::binary);
+    array_tree<I, S, L> & tree = readTree(file, storage);
+    parents.resize(tree.node_count);
+    correctTile(tree, tiled.tileRect(k), tiled.size, tiled.offsets[k], tiled.corrections, parents.data());
+    return tree;
+}
+
+/** \brief Whole tree of a tiled image in memory, for images which fit.
+ *
+ * Components are numbered by increasing level, so parents[i]+lc > i holds.
+ */
+template<typename I, typename S, typename L>
+array_tree<I, S, L> & assembleTree(
+    tiled_tree<I, S, L> const & tiled,
+    array_tree_storage<I, S, L> & storage
+)
+{
+    struct Component
+    {
+        L level;
+        global_id id;
+        global_id parent;
+    };
+
+    S const leaf_count = S(tiled.size.width)*S(tiled.size.height);
+    std::vector<global_id> leaf_parents(leaf_count);
+    std::vector<Component> components;
+    {
+        array_tree_storage<I, S, L> tile_storage;
+        std::vector<global_id> parents;
+        for(size_t k = 0; k < tiled.tileCount(); ++k)
+        {
+            array_tree<I, S, L> const & tile = loadTile(tiled, k, tile_storage, parents);
+            cv::Rect const rect = tiled.tileRect(k);
+            for(S l = 0; l < tile.leaf_count; ++l)
+            {
+                leaf_parents[S(rect.y + l/rect.width)*tiled.size.width + rect.x + l%rect.width] = parents[l];
+            }
+            for(S n = tile.leaf_count; n < tile.node_count; ++n)
+            {
+                global_id const id = tiled.offsets[k] + (n - tile.leaf_count);
+                if(!tiled.corrections.isAlias(id))
+                    components.push_back(Component{tile.comp_levels[n - tile.leaf_count], id, parents[n]});
+            }
+        }
+    }
+    for(auto const & c : tiled.corrections.components)
+    {
+        if(!tiled.corrections.isAlias(c.first))
+            components.push_back(Component{c.second, c.first, tiled.corrections.parent(c.first, NO_NODE)});
+    }
+    // parents have higher levels
+    std::stable_sort(components.begin(), components.end(),
+        [](Component const & a, Component const & b) { return a.level < b.level; }
+    );
+    std::unordered_map<global_id, I> index;
+    index.reserve(components.size());
+    for(size_t i = 0; i < components.size(); ++i)
+    {
+        index[components[i].id] = I(i);
+    }
+
+    array_tree<I, S, L> & tree = storage.init(leaf_count);
+    I const root = tree.node_capacity - tree.leaf_count;
+    auto parent = [&](global_id p) { return (p == NO_NODE) ? root : index.at(p); };
+    for(S l = 0; l < leaf_count; ++l)
+    {
+        tree.parents[l] = parent(leaf_parents[l]);
+    }
+    for(size_t i = 0; i < components.size(); ++i)
+    {
+        tree.parents[leaf_count + i] = parent(components[i].parent);
+        tree.comp_levels[i] = components[i].level;
+    }
+    tree.node_count = leaf_count + S(components.size());
+    return tree;
+}
+
+}//namespace image
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_IMAGE_OUTOFCORE_H_INCLUDED
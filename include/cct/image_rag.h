@@ -0,0 +1,224 @@
+#ifndef CONNECTED_COMPONENT_TREE_IMAGE_RAG_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_IMAGE_RAG_H_INCLUDED
+
+#include "cct/graph_builder.h"
+#include "cct/image_graph.h"
+#include "cct/array_storage.h"
+#include "cct/array_tree.h"
+#include "cct/root_finder.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+#include <opencv2/core/core.hpp>
+
+namespace cct {
+
+namespace image {
+
+/** \brief Aggregation of pixel edge weights along a region boundary.
+ *
+ * Min keeps the alpha-tree of regions equal to the pixel alpha-tree above the cut,
+ * Max and Mean give coarser, boundary strength based hierarchies.
+ */
+enum class BoundaryWeight
+{
+    Min,
+    Max,
+    Mean
+};
+
+/** \brief Labels of alpha-connected components at level alpha.
+ *
+ * Same regions as computeAlphaCut of the alpha-tree,
+ * but only union-find over edges <= alpha is needed, no tree is built.
+ * Regions are numbered from 0 in order of their first pixel.
+ * \returns region count
+ */
+template<typename T, typename I, typename Weight, typename EdgeWeightFunction>
+I getAlphaLabels(
+    cv::Size_<T> const & size,
+    Weight alpha,
+    EdgeWeightFunction e,//e(cv::Point, cv::Point)
+    I * labels//[vertexCount(size)]
+)
+{
+    typedef cv::Point_<T> Point;
+
+    I const n = I(size.width)*I(size.height);
+    I const none = std::numeric_limits<I>::max();
+
+    cct::PackedRootFinder<I, I> root(n, cct::LeafIndexTag());
+    forEachEdge(cv::Rect_<T>(0, 0, size.width, size.height),
+        [&](Point const & a, Point const & b)
+        {
+            if(alpha < e(a, b))
+                return;
+            I const ha = root.find_update(I(a.x) + I(a.y)*I(size.width));
+            I const hb = root.find_update(I(b.x) + I(b.y)*I(size.width));
+            if(ha != hb)
+                root.merge_set(ha, hb, root.data(ha));
+        }
+    );
+    // number regions by their first pixel
+    std::vector<I> ids(n, none);
+    I count = 0;
+    for(I p = 0; p < n; ++p)
+    {
+        I const h = root.find_update(p);
+        if(ids[h] == none)
+            ids[h] = count++;
+        labels[p] = ids[h];
+    }
+    return count;
+}
+
+/** \brief Edges of region adjacency graph.
+ *
+ * Pixel edges crossing region boundaries are bucketed by the lower region,
+ * each bucket is then aggregated into one edge per neighbour region.
+ * Every adjacent pair gets one edge with vertices[0] < vertices[1].
+ * O(vertex_count + region_count), memory O(boundary length)
+ */
+template<typename T, typename I, typename Weight, typename EdgeWeightFunction>
+void getRegionEdges(
+    cv::Size_<T> const & size,
+    I const * labels,//[vertexCount(size)]
+    I region_count,
+    EdgeWeightFunction e,//e(cv::Point, cv::Point)
+    BoundaryWeight boundary,
+    std::vector<cct::graph::Edge<I, Weight>> & edges
+)
+{
+    typedef cv::Point_<T> Point;
+    typedef cct::graph::Edge<I, Weight> Edge;
+
+    cv::Rect_<T> const rect(0, 0, size.width, size.height);
+    auto label = [&](Point const & p) -> I
+        {
+            return labels[I(p.x) + I(p.y)*I(size.width)];
+        };
+
+    // bucket boundary pixel edges by the lower region
+    std::vector<size_t> offsets(size_t(region_count)+1, 0);
+    forEachEdge(rect,
+        [&](Point const & a, Point const & b)
+        {
+            I const la = label(a);
+            I const lb = label(b);
+            if(la != lb)
+                ++offsets[std::min(la, lb)+1];
+        }
+    );
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<I> others(offsets[region_count]);
+    std::vector<Weight> weights(offsets[region_count]);
+    forEachEdge(rect,
+        [&](Point const & a, Point const & b)
+        {
+            I const la = label(a);
+            I const lb = label(b);
+            if(la != lb)
+            {
+                size_t const k = offsets[std::min(la, lb)]++;
+                others[k] = std::max(la, lb);
+                weights[k] = e(a, b);
+            }
+        }
+    );
+    // offsets are shifted by one bucket now
+    // aggregate, slots[b] is edge index of (a, b) if it is not before first edge of a
+    size_t const none = std::numeric_limits<size_t>::max();
+    std::vector<size_t> slots(region_count, none);
+    // boundary sums and lengths of edges for the mean
+    std::vector<double> sums;
+    std::vector<size_t> counts;
+    edges.clear();
+    size_t k = 0;
+    for(I a = 0; a < region_count; ++a)
+    {
+        size_t const first = edges.size();
+        for(; k < offsets[a]; ++k)
+        {
+            I const b = others[k];
+            Weight const w = weights[k];
+            size_t const s = slots[b];
+            if((s == none) || (s < first))
+            {
+                slots[b] = edges.size();
+                Edge edge;
+                edge.vertices[0] = a;
+                edge.vertices[1] = b;
+                edge.weight = w;
+                edges.push_back(edge);
+                if(boundary == BoundaryWeight::Mean)
+                {
+                    sums.push_back(w);
+                    counts.push_back(1);
+                }
+                continue;
+            }
+            switch(boundary)
+            {
+            case BoundaryWeight::Min :
+                edges[s].weight = std::min(edges[s].weight, w);
+                break;
+            case BoundaryWeight::Max :
+                edges[s].weight = std::max(edges[s].weight, w);
+                break;
+            case BoundaryWeight::Mean :
+                sums[s] += w;
+                ++counts[s];
+                break;
+            }
+        }
+    }
+    if(boundary == BoundaryWeight::Mean)
+    {
+        for(size_t i = 0; i < edges.size(); ++i)
+            edges[i].weight = Weight(sums[i]/counts[i]);
+    }
+}
+
+/** \brief Two stage alpha-tree over regions.
+ *
+ * 1. image is over-segmented into alpha-connected components at alpha
+ * 2. alpha-tree of their region adjacency graph is built by the generic graph builder
+ * Leaves of the tree are regions, labels map pixels to them.
+ * Node count drops by the mean region size, while the top of the hierarchy
+ * is kept exactly for BoundaryWeight::Min.
+ */
+template<
+    typename T, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction
+>
+array_tree<I, S, Weight> & buildRegionAlphaTree(
+    cv::Size_<T> const & size,
+    Weight alpha,
+    array_tree_storage<I, S, Weight> & storage,
+    EdgeWeightFunction e,//e(cv::Point, cv::Point)
+    BoundaryWeight boundary,
+    I * labels//[vertexCount(size)]
+)
+{
+    typedef cct::graph::Edge<I, Weight> Edge;
+
+    I const region_count = getAlphaLabels(size, alpha, e, labels);
+
+    std::vector<Edge> edges;
+    getRegionEdges(size, labels, region_count, e, boundary, edges);
+
+    return cct::graph::buildAlphaTree(region_count, edges.data(), edges.size(), storage);
+}
+
+}//namespace image
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_IMAGE_RAG_H_INCLUDED
@@ -0,0 +1,143 @@
+#ifndef CONNECTED_COMPONENT_TREE_IMAGE_SALIENCY_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_IMAGE_SALIENCY_H_INCLUDED
+
+#include "cct/array_export.h"
+#include "cct/array_lca.h"
+#include "cct/image_graph.h"
+
+#include "utils/parallel.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace cct {
+
+namespace image {
+
+/** \brief Ultrametric contour map of an image tree.
+ *
+ * Every 4-connected edge gets the level of the LCA of its pixels.
+ * The output uses the doubled grid [(2*height-1) x (2*width-1)] :
+ *  (2y  , 2x  ) - pixel (x,y), set to 0
+ *  (2y  , 2x+1) - edge (x,y)-(x+1,y)
+ *  (2y+1, 2x  ) - edge (x,y)-(x,y+1)
+ *  (2y+1, 2x+1) - maximum of the four surrounding edges
+ *
+ * The maximum of a 4-cycle in an ultrametric is attained at least twice,
+ * so the crossing is computed from the edges of its own row pair only.
+ * O(1) per edge, rows are split among threads.
+ */
+template<typename T, typename Tree>
+void saliencyMap(
+    cv::Size_<T> const & size,
+    array_lca<Tree> const & lca,
+    cv::Mat & saliency,
+    unsigned threads = 1
+)
+{
+    typedef typename Tree::size_type size_type;
+    typedef typename Tree::level_type level_type;
+
+    BOOST_ASSERT(size.width  > T(0));
+    BOOST_ASSERT(size.height > T(0));
+
+    size_type const w = size.width;
+    size_type const h = size.height;
+
+    saliency.create(2*h-1, 2*w-1, cv::DataType<level_type>::type);
+
+    utils::parallelFor(0, h, threads,
+        [&](size_t begin, size_t end)
+        {
+            for(size_type y = begin; y < end; ++y)
+            {
+                size_type const row = y*w;
+                level_type * s0 = saliency.ptr<level_type>(2*y);
+                for(size_type x = 0; x+1 < w; ++x)
+                {
+                    s0[2*x  ] = level_type(0);
+                    s0[2*x+1] = lca.distance(row+x, row+x+1);
+                }
+                s0[2*(w-1)] = level_type(0);
+                if(y+1 < h)
+                {
+                    level_type * s1 = saliency.ptr<level_type>(2*y+1);
+                    level_type left = s1[0] = lca.distance(row, row+w);
+                    for(size_type x = 0; x+1 < w; ++x)
+                    {
+                        level_type const right = s1[2*x+2] = lca.distance(row+x+1, row+x+1+w);
+                        s1[2*x+1] = std::max(s0[2*x+1], std::max(left, right));
+                        left = right;
+                    }
+                }
+            }
+        }
+    );
+}
+
+/** \brief Ultrametric contour map of an array_tree.
+ *
+ * Children are (re)built and the LCA index is created internally.
+ */
+template<typename T, typename I, typename S, typename L>
+void saliencyMap(
+    cv::Size_<T> const & size,
+    array_tree<I, S, L> & tree,
+    cv::Mat & saliency,
+    unsigned threads = 1
+)
+{
+    BOOST_ASSERT(S(size.width)*S(size.height) == tree.leaf_count);
+    tree.build_children();
+    array_lca<array_tree<I, S, L>> const lca(tree);
+    saliencyMap(size, lca, saliency, threads);
+}
+
+/** \brief Ultrametric contour map of a pointer tree.
+ *
+ * The tree is exported to a temporary array_tree first.
+ */
+template<typename T, typename Component, typename Leaf>
+void saliencyMap(
+    cv::Size_<T> const & size,
+    Tree<Component, Leaf> const & tree,
+    cv::Mat & saliency,
+    unsigned threads = 1
+)
+{
+    typedef typename Tree<Component, Leaf>::size_type size_type;
+    typedef decltype(std::declval<Component>().level()) level_type;
+    typedef array_tree<size_type, size_type, level_type> Array;
+
+    size_type const lc = tree.leafCount();
+    BOOST_ASSERT(size_type(size.width)*size_type(size.height) == lc);
+
+    // one spare node, so even a tree without components has a root mark
+    std::vector<size_type> parents(tree.nodeCount()+1);
+    std::vector<level_type> levels(tree.componentCount()+1);
+    std::vector<size_type> child_count(tree.componentCount()+4);
+    std::vector<size_type> children(tree.nodeCount());
+
+    Array a;
+    a.leaf_count = lc;
+    a.node_count = lc;
+    a.node_capacity = tree.nodeCount()+1;
+    a.invalid_count = 0;
+    a.parents = parents.data();
+    a.leaf_levels = nullptr;
+    a.comp_levels = levels.data();
+    a.child_count = child_count.data();
+    a.children = children.data();
+
+    exportTree(tree, a);
+    saliencyMap(size, a, saliency, threads);
+}
+
+}//namespace image
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_IMAGE_SALIENCY_H_INCLUDED
@@ -0,0 +1,414 @@
+#ifndef CONNECTED_COMPONENT_TREE_IMAGE_SHAPES_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_IMAGE_SHAPES_H_INCLUDED
+
+#include "cct/array_tree.h"
+#include "cct/root_finder.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+#include <opencv2/core/core.hpp>
+
+namespace cct {
+
+namespace image {
+
+/** \brief Interval valued image on the Khalimsky grid.
+ *
+ * Image is surrounded by one pixel border of median border value
+ * and subdivided by median interpolation, so it becomes well-composed
+ * and upper and lower level sets have the same connectivity (self-dual).
+ * Medians of an even count are means of the middle values,
+ * so values are doubled : pixel value v is level 2v.
+ * Subdivided image is immersed into the grid :
+ *  bordered pixel (x, y) is face (4x, 4y),
+ *  faces with both coordinates even get interpolated values,
+ *  other faces get span of their neighbours.
+ * Grid is framed by one face, so neighbours of faces need no bounds checks.
+ */
+template<typename I>
+struct ShapesGrid
+{
+    // doubled 8 bit values
+    static constexpr unsigned level_count = 511;
+
+    // size without frame
+    I width;
+    I height;
+    // row stride
+    I stride;
+    std::vector<uint16_t> lower;//[size()]
+    std::vector<uint16_t> upper;//[size()]
+
+    explicit ShapesGrid(cv::Mat const & image)
+        : width(4*(image.cols+2)-3), height(4*(image.rows+2)-3), stride(width+2),
+        lower(size()), upper(size())
+    {
+        BOOST_ASSERT(image.type() == CV_8UC1);
+        int const w = image.cols;
+        int const h = image.rows;
+        // median of border, count is even
+        std::vector<uint8_t> border;
+        for(int x = 0; x < w; ++x)
+        {
+            border.push_back(image.at<uint8_t>(0, x));
+            border.push_back(image.at<uint8_t>(h-1, x));
+        }
+        for(int y = 0; y < h; ++y)
+        {
+            border.push_back(image.at<uint8_t>(y, 0));
+            border.push_back(image.at<uint8_t>(y, w-1));
+        }
+        size_t const half = border.size()/2;
+        std::nth_element(border.begin(), border.begin()+half, border.end());
+        uint16_t const median = uint16_t(border[half]) + *std::max_element(border.begin(), border.begin()+half);
+        // pixels
+        for(I y = 0; y < height; y += 4)
+        {
+            for(I x = 0; x < width; x += 4)
+            {
+                I const px = x/4;
+                I const py = y/4;
+                bool const inside = (px > 0) && (py > 0) && (px <= I(w)) && (py <= I(h));
+                lower[face(x, y)] = inside ? uint16_t(2*image.at<uint8_t>(py-1, px-1)) : median;
+            }
+        }
+        // means of horizontal and vertical neighbours
+        for(I y = 0; y < height; y += 4)
+        {
+            for(I x = 2; x < width; x += 4)
+            {
+                I const i = face(x, y);
+                lower[i] = (lower[i-2] + lower[i+2])/2;
+            }
+        }
+        for(I y = 2; y < height; y += 4)
+        {
+            for(I x = 0; x < width; x += 4)
+            {
+                I const i = face(x, y);
+                lower[i] = (lower[i-2*stride] + lower[i+2*stride])/2;
+            }
+        }
+        // means of middle values of 4 diagonal neighbours
+        for(I y = 2; y < height; y += 4)
+        {
+            for(I x = 2; x < width; x += 4)
+            {
+                I const i = face(x, y);
+                unsigned const a = lower[i-2*stride-2];
+                unsigned const b = lower[i-2*stride+2];
+                unsigned const c = lower[i+2*stride-2];
+                unsigned const d = lower[i+2*stride+2];
+                unsigned const sum = a + b + c + d;
+                unsigned const extremes = std::min(std::min(a, b), std::min(c, d))
+                    + std::max(std::max(a, b), std::max(c, d));
+                lower[i] = uint16_t((sum - extremes)/2);
+            }
+        }
+        for(I y = 0; y < height; y += 2)
+        {
+            for(I x = 0; x < width; x += 2)
+            {
+                I const i = face(x, y);
+                upper[i] = lower[i];
+            }
+        }
+        // spans of horizontal, then vertical neighbours
+        for(I y = 0; y < height; y += 2)
+        {
+            for(I x = 1; x < width; x += 2)
+            {
+                I const i = face(x, y);
+                lower[i] = std::min(lower[i-1], lower[i+1]);
+                upper[i] = std::max(upper[i-1], upper[i+1]);
+            }
+        }
+        for(I y = 1; y < height; y += 2)
+        {
+            for(I x = 0; x < width; ++x)
+            {
+                I const i = face(x, y);
+                lower[i] = std::min(lower[i-stride], lower[i+stride]);
+                upper[i] = std::max(upper[i-stride], upper[i+stride]);
+            }
+        }
+    }
+
+    /** \brief Array size including frame */
+    I size() const
+    {
+        return stride*(height+2);
+    }
+
+    /** \brief Face count without frame */
+    I count() const
+    {
+        return width*height;
+    }
+
+    /** \brief Array index of face */
+    I face(I x, I y) const
+    {
+        return (y+1)*stride + x+1;
+    }
+
+    /** \brief Array index of image pixel */
+    I pixel(I x, I y) const
+    {
+        return face(4*(x+1), 4*(y+1));
+    }
+};
+
+/** \brief Propagation order of faces for the tree of shapes.
+ *
+ * Faces are flooded from the border by a hierarchical queue,
+ * the current level moves to the nearest non-empty one.
+ * Each face gets the current level clamped to its span.
+ * Parents precede children in order.
+ */
+template<typename I>
+void getShapesOrder(
+    ShapesGrid<I> const & grid,
+    I * order,//[grid.count()]
+    uint16_t * levels//[grid.size()]
+)
+{
+    I const count = grid.count();
+    I const stride = grid.stride;
+    // whole words of the nonempty mask
+    size_t const bins = (ShapesGrid<I>::level_count + 63)/64*64;
+
+    // FIFO per level, head[l] is the first unprocessed
+    std::vector<std::vector<I>> queues(bins);
+    std::vector<size_t> heads(bins, 0);
+    // bit l is set if queue l is not empty
+    uint64_t nonempty[bins/64] = {};
+    // frame is never pushed
+    std::vector<bool> done(grid.size(), true);
+    for(I y = 0; y < grid.height; ++y)
+    {
+        std::fill_n(done.begin()+grid.face(0, y), grid.width, false);
+    }
+
+    auto push = [&](I i, unsigned l)
+        {
+            l = std::min<unsigned>(std::max<unsigned>(l, grid.lower[i]), grid.upper[i]);
+            queues[l].push_back(i);
+            nonempty[l/64] |= uint64_t(1) << (l%64);
+            done[i] = true;
+        };
+    // nearest non-empty level above l or bins
+    auto next_above = [&](unsigned l) -> unsigned
+        {
+            unsigned w = l/64;
+            uint64_t mask = (l%64 == 63) ? 0 : (nonempty[w] & (~uint64_t(0) << (l%64+1)));
+            while(!mask)
+            {
+                if(++w == bins/64)
+                    return bins;
+                mask = nonempty[w];
+            }
+            return w*64 + __builtin_ctzll(mask);
+        };
+    // nearest non-empty level below l or bins
+    auto next_below = [&](unsigned l) -> unsigned
+        {
+            unsigned w = l/64;
+            uint64_t mask = nonempty[w] & ((uint64_t(1) << (l%64)) - 1);
+            while(!mask)
+            {
+                if(w == 0)
+                    return bins;
+                mask = nonempty[--w];
+            }
+            return w*64 + 63-__builtin_clzll(mask);
+        };
+
+    unsigned l = grid.lower[grid.face(0, 0)];
+    push(grid.face(0, 0), l);
+    for(I k = 0; k < count; ++k)
+    {
+        if(heads[l] == queues[l].size())
+        {
+            queues[l].clear();
+            heads[l] = 0;
+            nonempty[l/64] &= ~(uint64_t(1) << (l%64));
+            // nearest non-empty level, lower one on tie
+            unsigned const above = next_above(l);
+            unsigned const below = next_below(l);
+            BOOST_ASSERT((above < bins) || (below < bins));
+            l = ((below < bins) && ((above == bins) || (l-below <= above-l))) ? below : above;
+        }
+        I const i = queues[l][heads[l]++];
+        order[k] = i;
+        levels[i] = l;
+
+        if(!done[i-1])
+            push(i-1, l);
+        if(!done[i+1])
+            push(i+1, l);
+        if(!done[i-stride])
+            push(i-stride, l);
+        if(!done[i+stride])
+            push(i+stride, l);
+    }
+}
+
+/** \brief Tree of shapes of CV_8UC1 image (Geraud et al. quasi-linear algorithm).
+ *
+ * Faces of the Khalimsky grid are sorted by propagation from the border,
+ * tree is then built by union-find in reverse order as max-tree.
+ * Shapes are saturated level sets of the median interpolated image (see ShapesGrid),
+ * so the image and its negative have the same shapes.
+ * Result is restricted to image pixels :
+ *  leaves are pixels with leaf_levels set to pixel values,
+ *  components are shapes with at least two pixels or child shapes,
+ *  shapes at interpolated levels between pixel values get the lower one.
+ * Components are ordered from leaves to the root, so parents[i]+lc > i.
+ * Quasi-linear time, 16n faces of memory.
+ * Every face is queued and united with its 4 neighbours,
+ * so the build is about 30x slower than the alpha-tree with its 2n edges.
+ */
+template<typename I, typename S, typename L>
+void buildTreeOfShapes(
+    cv::Mat const & image,
+    array_tree<I, S, L> & tree
+)
+{
+    BOOST_ASSERT(image.type() == CV_8UC1);
+    BOOST_ASSERT(I(image.cols)*I(image.rows) == tree.leaf_count);
+    BOOST_ASSERT(tree.leaf_levels);
+
+    I const w = image.cols;
+    I const h = image.rows;
+    I const lc = tree.leaf_count;
+    I const root = tree.node_capacity-lc;
+
+    ShapesGrid<I> grid(image);
+    I const count = grid.count();
+    I const stride = grid.stride;
+
+    std::vector<I> order(count);
+    std::vector<uint16_t> levels(grid.size());
+    getShapesOrder(grid, order.data(), levels.data());
+    // spans are not needed anymore, free them before the union-find
+    std::vector<uint16_t>().swap(grid.lower);
+    std::vector<uint16_t>().swap(grid.upper);
+
+    // union-find in reverse order
+    std::vector<I> parents(grid.size());
+    {
+        cct::PackedRootFinder<I, I> zpar(grid.size(), cct::LeafIndexTag());
+        // frame is never done
+        std::vector<bool> done(grid.size(), false);
+
+        auto link = [&](I p, I q)
+            {
+                if(!done[q])
+                    return;
+                I const hp = zpar.find_update(p);
+                I const hq = zpar.find_update(q);
+                if(hp != hq)
+                {
+                    parents[zpar.data(hq)] = p;
+                    zpar.merge_set(hp, hq, p);
+                }
+            };
+
+        for(I k = count; k-- > 0;)
+        {
+            I const p = order[k];
+            parents[p] = p;
+            done[p] = true;
+            link(p, p-1);
+            link(p, p+1);
+            link(p, p-stride);
+            link(p, p+stride);
+        }
+    }
+    // canonize from root to leaves
+    for(I k = 0; k < count; ++k)
+    {
+        I const p = order[k];
+        I const q = parents[p];
+        if(levels[parents[q]] == levels[q])
+            parents[p] = parents[q];
+    }
+
+    auto zone = [&](I p) -> I
+        {
+            return (levels[parents[p]] == levels[p]) ? parents[p] : p;
+        };
+
+    tree.reset();
+
+    // count pixels and non-empty child shapes
+    std::vector<I> counts(grid.size(), 0);
+    for(I y = 0; y < h; ++y)
+    {
+        for(I x = 0; x < w; ++x)
+        {
+            I const p = grid.pixel(x, y);
+            ++counts[zone(p)];
+            tree.leaf_levels[y*w+x] = L(levels[p]/2);
+        }
+    }
+    for(I k = count; k-- > 1;)
+    {
+        I const p = order[k];
+        if((zone(p) == p) && (counts[p] > 0))
+            ++counts[parents[p]];
+    }
+    BOOST_ASSERT(zone(order[0]) == order[0]);
+
+    // components in reverse order, shapes with a single element are skipped
+    // counts now hold target nodes : comp index or none for root
+    S comp_count = 0;
+    for(I k = count; k-- > 0;)
+    {
+        I const p = order[k];
+        if((zone(p) == p) && (counts[p] > 1))
+            ++comp_count;
+    }
+    BOOST_ASSERT(lc + comp_count <= tree.node_capacity);
+    tree.node_count = lc + comp_count;
+    S c = comp_count;
+    for(I k = 0; k < count; ++k)
+    {
+        I const p = order[k];
+        if(zone(p) != p)
+            continue;
+        I const parent = (k == 0) ? root : counts[parents[p]];
+        if(counts[p] > 1)
+        {
+            --c;
+            tree.parents[c+lc] = parent;
+            tree.comp_levels[c] = L(levels[p]/2);
+            counts[p] = c;
+        }
+        else
+        {
+            counts[p] = parent;
+        }
+    }
+    BOOST_ASSERT(c == 0);
+    for(I y = 0; y < h; ++y)
+    {
+        for(I x = 0; x < w; ++x)
+        {
+            tree.parents[y*w+x] = counts[zone(grid.pixel(x, y))];
+        }
+    }
+}
+
+}//namespace image
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_IMAGE_SHAPES_H_INCLUDED
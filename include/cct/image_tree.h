@@ -1,25 +1,40 @@
 #ifndef CONNECTED_COMPONENT_TREE_IMAGE_TREE_H_INCLUDED
 #define CONNECTED_COMPONENT_TREE_IMAGE_TREE_H_INCLUDED
 
+#include "index_node.h"
 #include "node.h"
 #include "tree.h"
 #include "builder.h"
 #include "image_graph.h"
 
+#include "utils/parallel.h"
+#include "utils/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <queue>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
-#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
 
 namespace cct {
 
 namespace image {
 
-template<typename Level>
+/** \brief Component of image tree.
+ *
+ * Base is cct::ComponentBase (pointer links)
+ * or cct::IndexComponentBase (32 bit links, used with Leaf = IndexLeaf).
+ */
+template<typename Level, typename Base = cct::ComponentBase>
 class Component
-    : public cct::ComponentBase
+    : public Base
 {
 private :
-    typedef cct::ComponentBase Base;
     Level m_level;
 public :
     template<typename T, typename W>
@@ -70,19 +85,26 @@ public :
     }
 };
 
-template<typename L>
-std::ostream & operator<<(std::ostream & o, Component<L> const & c)
+template<typename L, typename B>
+std::ostream & operator<<(std::ostream & o, Component<L, B> const & c)
 {
     return o << c.level();
 }
 
-std::ostream & operator<<(std::ostream & o, Component<uint8_t> const & c)
+template<typename B>
+std::ostream & operator<<(std::ostream & o, Component<uint8_t, B> const & c)
 {
     return o << unsigned(c.level());
 }
 
 typedef cct::LeafBase Leaf;
 
+/** \brief Nodes with 32 bit links, half the memory of Component and Leaf. */
+template<typename Level>
+using IndexComponent = Component<Level, cct::IndexComponentBase>;
+
+typedef cct::IndexLeafBase IndexLeaf;
+
 /** \brief Alpha-tree construction
  */
 template<
@@ -110,19 +132,92 @@ void buildAlphaTree(
     unsigned depth // Depth of the binary parallelization tree
 );
 
-/*
-template<typename T,
+/** \brief Parallel alpha-tree construction on a grid of tiles.
+ *
+ * Image is cut into grid.width x grid.height tiles of nearly equal size,
+ * their trees are built concurrently by tasks of the pool.
+ * Neighbouring tile ranges are then merged bottom-up, halving across the longer side,
+ * so seams get merged in a balanced binary schedule.
+ * Any thread count works, load is balanced by using more tiles than threads.
+ */
+template<
+    typename T,
+    typename Builder,
+    typename EdgeWeightFunction
+    >
+void buildAlphaTree(
+    cv::Size_<T> const & size, // Image size, the actual image is hidden in WeightFunction
+    cv::Size_<T> const & tile, // Tile size for tiled image scan. Set to <size> to disable tiled scan.
+    Builder & builder, // Tree builder to use
+    EdgeWeightFunction e, // Function for edge weight calculation
+    cv::Size_<T> const & grid, // Tile columns and rows, at most one tile per pixel
+    utils::ThreadPool & pool = utils::ThreadPool::global() // Threads to use
+);
+
+/** \brief Forest of independent tile trees, without merging.
+ *
+ * Tiles of the grid are built concurrently like in the grid mode of buildAlphaTree,
+ * but the serial merge phase is skipped : every tile tree ends up as a root of the tree.
+ * Edges between neighbouring tiles are returned in connectors, stably sorted by weight,
+ * so the complete tree can be merged later from the forest by mergeForest.
+ * One pixel tiles have no edges, their leaves stay without parent.
+ * \return number of connectors
+ */
+template<
+    typename T,
+    typename Builder,
+    typename EdgeWeightFunction,
+    typename Edge
+    >
+size_t buildAlphaTreeNomerge(
+    cv::Size_<T> const & size, // Image size, the actual image is hidden in WeightFunction
+    cv::Size_<T> const & tile, // Tile size for tiled image scan. Set to <size> to disable tiled scan.
+    Builder & builder, // Tree builder to use
+    EdgeWeightFunction e, // Function for edge weight calculation
+    cv::Size_<T> const & grid, // Tile columns and rows, at most one tile per pixel
+    std::vector<Edge> & connectors, // Edges between tiles, sorted by weight
+    utils::ThreadPool & pool = utils::ThreadPool::global() // Threads to use
+);
+
+/** \brief Merge forest of buildAlphaTreeNomerge along its connectors.
+ *
+ * Builder must not be reset after buildAlphaTreeNomerge.
+ * Connectors are merged serially in order, the result is the tree of buildAlphaTree,
+ * up to degenerate components.
+ */
+template<
+    typename T,
+    typename Builder,
+    typename Edge
+    >
+void mergeForest(
+    cv::Size_<T> const & size, // Image size
+    Builder & builder, // Builder of the forest
+    std::vector<Edge> const & connectors // Edges between tiles, sorted by weight
+);
+
+/** \brief Second-order tree construction
+ *
+ * Vertices and edges are processed in one pass in order of their weights,
+ * vertex goes first on equal weights.
+ * Every leaf gets a component at its vertex level.
+ *
+ * REQUIRES :
+ *  edge weight >= weights of both its vertices
+ */
+template<
+    typename T,
     typename Builder,
     typename VertexWeightFunction,
     typename EdgeWeightFunction
     >
 void buildSecondOrderTree(
-        cv::Rect_<T> const & rect,
-        Builder & builder,
-        VertexWeightFunction v,
-        EdgeWeightFunction e
-        );
-*/
+    cv::Size_<T> const & size, // Image size, the actual image is hidden in weight functions
+    cv::Size_<T> const & tile, // Tile size for tiled image scan. Set to <size> to disable tiled scan.
+    Builder & builder, // Tree builder to use
+    VertexWeightFunction v, // Function for vertex weight calculation
+    EdgeWeightFunction e // Function for edge weight calculation
+);
 #include "image_tree.inl"
 
 }//namespace image
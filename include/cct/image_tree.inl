@@ -36,62 +36,472 @@ void buildAlphaTree(
     builder.finish(std::move(thread_builder));
 }
 
+// Serial construction of the subtree of one rectangle
 template<
     typename T,
     typename B,
     typename WeightFunction
     >
-void buildAlphaTree(
+void buildAlphaTreeTile(
     cv::Size_<T> const & size,
     cv::Size_<T> const & tile,
     ThreadBuilder<B> & builder,
     WeightFunction e,
-    unsigned treeDepth,
     cv::Rect_<T> const & rect
 )
 {
     typedef cv::Point_<T> Point;
     typedef decltype(e(Point(),Point())) Weight;
     typedef Edge<T, Weight> Edge;
-    typedef typename B::Component Component;
 
-    if(treeDepth == 0)
+    size_t ec = edgeCount(rect.size());
+    if(ec == 0)
+        return;
+    std::vector<Edge> edges(ec);
+    size_t count = getSortedImageEdges(rect, tile, &edges[0], e);
+
+    size_t remaining_merges = vertexCount(rect.size())-1;
+
+    Weight lastWeight = edges[0].weight;
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(lastWeight < edges[i].weight)
+        {
+            builder.remove();
+            lastWeight = edges[i].weight;
+        }
+        if(builder.addEdge(
+            pointId(edges[i].points[0], size),
+            pointId(edges[i].points[1], size),
+            edges[i])
+        )
+        {
+            if(--remaining_merges == 0)
+                break;
+        }
+    }
+    builder.remove();
+}
+
+// Seam between neighbouring rectangles, ra is left of or above rb
+template<typename T>
+struct Seam
+{
+    typedef cv::Point_<T> Point;
+
+    // first pixels on both sides
+    Point a;
+    Point b;
+    // direction along the seam
+    Point step;
+    T length;
+
+    Seam(cv::Rect_<T> const & ra, cv::Rect_<T> const & rb)
+    {
+        if(ra.y == rb.y)
+        {
+            // vertical seam
+            BOOST_ASSERT(ra.x+ra.width == rb.x);
+            a = Point(ra.x+ra.width-1, ra.y);
+            step = Point(0, 1);
+            length = ra.height;
+        }
+        else
+        {
+            // horizontal seam
+            BOOST_ASSERT(ra.y+ra.height == rb.y);
+            a = Point(ra.x, ra.y+ra.height-1);
+            step = Point(1, 0);
+            length = ra.width;
+        }
+        b = Point(rb.x, rb.y);
+    }
+};
+
+// Sorted edges across the seam, points[0] is on side a
+template<
+    typename T,
+    typename WeightFunction,
+    typename Edge
+    >
+size_t getSortedSeam(
+    Seam<T> const & seam,
+    WeightFunction e,
+    std::vector<Edge> & edges
+)
+{
+    edges.resize(seam.length);
+    if(seam.step.y)
+        return getSortedHorizontalConnectors(seam.a, seam.length, &edges[0], e);
+    else
+        return getSortedVerticalConnectors(seam.a, seam.length, &edges[0], e);
+}
+
+/* Links of one merge task to components above its bound.
+ *
+ * These components are shared by all tasks, so children are relinked under striped locks.
+ * Every cut link is kept with a leaf below the unlinked child,
+ * the leaf is joined to the old parent again after all tasks finish.
+ */
+template<typename Component, typename size_type>
+class SeamBoundary
+{
+public :
+    typedef std::pair<Component *, size_type> Cut;
+
+    static constexpr size_t lock_count = 64;
+private :
+    boost::mutex * m_locks;
+
+    std::vector<Cut> m_cuts;
+
+    boost::mutex & lock(Component const * p)
+    {
+        return m_locks[reinterpret_cast<std::uintptr_t>(p)/sizeof(Component) % lock_count];
+    }
+public :
+    // locks[lock_count] are shared by all boundaries of a seam
+    explicit SeamBoundary(boost::mutex * locks)
+        : m_locks(locks)
+    {}
+
+    template<typename Node>
+    void unlink(Node * node, size_type leaf)
     {
-        size_t ec = edgeCount(rect.size());
-        std::vector<Edge> edges(ec);
-        size_t count = getSortedImageEdges(rect, tile, &edges[0], e);
+        Component * p = static_cast<Component *>(node->parent());
+        {
+            boost::mutex::scoped_lock l(lock(p));
+            node->unlink();
+        }
+        m_cuts.push_back(Cut(p, leaf));
+    }
 
-        size_t remaining_merges = vertexCount(rect.size())-1;
+    void link(Component * node)
+    {
+        BOOST_ASSERT(!m_cuts.empty());
+        Component * p = m_cuts.back().first;
+        m_cuts.pop_back();
+        boost::mutex::scoped_lock l(lock(p));
+        p->link(node);
+    }
+
+    std::vector<Cut> const & cuts() const
+    {
+        return m_cuts;
+    }
+};
 
-        Weight lastWeight = edges[0].weight;
+/* Merge subtree of other half into builder along sorted seam edges.
+ *
+ * Long seams are merged in rounds, with the same result as merging edge by edge.
+ * Every round takes the lower half of the pending edges, up to a bound level :
+ * - Highest components up to the bound above the pixels root disjoint subtrees,
+ *   edges joining the same subtrees form a group, groups are merged by tasks of the pool.
+ *   Paths are zipped up to the bound only (ThreadBuilder::merge_paths_below),
+ *   links to the shared components above it are cut.
+ * - Every cut link becomes a pending edge from its leaf to the old parent, at the parent level.
+ * Subtrees up to the bound stay as they are in later rounds,
+ * so paths are followed from their tops, which are looked up in parallel,
+ * and edges inside one subtree are skipped. The last few edges are merged serially.
+ */
+template<
+    typename T,
+    typename B,
+    typename Edge
+    >
+void mergeSeam(
+    cv::Size_<T> const & size,
+    ThreadBuilder<B> & builder,
+    ThreadBuilder<B> && other,
+    Edge const * edges,
+    size_t count,
+    utils::ThreadPool & pool
+)
+{
+    typedef typename B::Component Component;
+    typedef typename B::Leaf Leaf;
+    typedef typename B::Node Node;
+    typedef typename B::size_type size_type;
+    typedef typename Edge::Weight Weight;
+    typedef SeamBoundary<Component, size_type> Boundary;
+    typedef typename Boundary::Cut Cut;
+
+    auto leafId = [&](cv::Point_<T> const & p) { return size_type(pointId(p, size)); };
+    auto point = [&](size_type i) { return cv::Point_<T>(T(i % size.width), T(i / size.width)); };
+
+    builder.absorb(std::move(other));
+    size_t const chunk = 4096;
+    if((count < 2*chunk) || (pool.workerCount() == 0))
+    {
         for(size_t i = 0; i < count; ++i)
         {
-            if(lastWeight < edges[i].weight)
+            size_type const a = leafId(edges[i].points[0]);
+            size_type const b = leafId(edges[i].points[1]);
+            Component * n = builder.merge_roots(a, b, edges[i]);
+            if(*n <= edges[i])
+                break;
+            builder.merge_paths(a, b, edges[i]);
+        }
+        return;
+    }
+    // join both trees, edges at or above the root level change nothing
+    Component const * root = builder.merge_roots(
+        leafId(edges[0].points[0]), leafId(edges[0].points[1]), edges[0]);
+    Edge const * const end = std::partition_point(edges, edges+count,
+        [&](Edge const & edge) { return !(*root <= edge); });
+
+    // edges with the highest components up to the last bound above both pixels,
+    // nullptr for a leaf
+    struct Pending
+    {
+        Edge edge;
+        Component * tops[2];
+    };
+    std::vector<Pending> pending(end-edges);
+    for(size_t i = 0; i < pending.size(); ++i)
+    {
+        pending[i].edge = edges[i];
+        pending[i].tops[0] = pending[i].tops[1] = nullptr;
+    }
+    unsigned const threads = unsigned(pool.workerCount()+1);
+    // highest component up to bound on the path of a leaf, starting at n
+    auto top = [&](size_type leaf, Component * n, Edge const & bound, size_t & steps)
+    {
+        Component * p = static_cast<Component *>(
+            n ? n->parent() : builder.tree().leaf(leaf)->parent());
+        while(p && (*p <= bound))
+        {
+            n = p;
+            p = static_cast<Component *>(p->parent());
+            ++steps;
+        }
+        return n;
+    };
+    // returns number of components passed
+    auto findTops = [&](Pending * first, size_t n, Edge const & bound)
+    {
+        std::atomic<size_t> steps(0);
+        utils::parallelFor(0, n, threads, [&](size_t b, size_t e)
+        {
+            size_t s = 0;
+            for(Pending * i = first+b; i != first+e; ++i)
+            {
+                i->tops[0] = top(leafId(i->edge.points[0]), i->tops[0], bound, s);
+                i->tops[1] = top(leafId(i->edge.points[1]), i->tops[1], bound, s);
+            }
+            steps += s;
+        }, pool);
+        return size_t(steps);
+    };
+    // both pixels in one subtree, they are joined below the edge already
+    auto joined = [](Pending const & e) { return e.tops[0] && (e.tops[0] == e.tops[1]); };
+    auto lower = [](Pending const & x, Pending const & y) { return x.edge < y.edge; };
+
+    while(pending.size() >= 2*chunk)
+    {
+        Edge const bound = pending[(pending.size()-1)/2].edge;
+        size_t const middle = std::partition_point(pending.begin(), pending.end(),
+            [&](Pending const & e) { return !(bound < e.edge); }) - pending.begin();
+
+        // subtrees up to bound above both pixels
+        std::vector<Pending> round(pending.begin(), pending.begin()+middle);
+        // zips of short paths are not worth the tasks, two components per path at least
+        if(findTops(round.data(), middle, bound) < 4*middle)
+            break;
+
+        // groups of edges joining the same subtrees
+        uint32_t const none = uint32_t(-1);
+        std::unordered_map<Node const *, uint32_t> ids;
+        cct::PackedRootFinder<uint32_t, uint32_t> groups(2*middle, cct::LeafIndexTag());
+        std::vector<uint32_t> group_of(middle, none);
+        for(size_t i = 0; i < middle; ++i)
+        {
+            if(joined(pending[i]))
+                continue;
+            uint32_t id[2];
+            for(int side = 0; side < 2; ++side)
             {
-                builder.remove();
-                lastWeight = edges[i].weight;
+                Component const * t = round[i].tops[side];
+                Node const * n = t ? static_cast<Node const *>(t) :
+                    builder.tree().leaf(leafId(round[i].edge.points[side]));
+                id[side] = ids.insert(std::make_pair(n, uint32_t(ids.size()))).first->second;
             }
-            if(builder.addEdge(
-                pointId(edges[i].points[0], size),
-                pointId(edges[i].points[1], size),
-                edges[i])
-            )
+            auto const ha = groups.find_update(id[0]);
+            auto const hb = groups.find_update(id[1]);
+            if(ha != hb)
+                groups.merge(ha, hb);
+            group_of[i] = id[0];
+        }
+
+        // pack groups into tasks, edges keep their order
+        size_t const task_size = std::max(middle/(4*threads), size_t(256));
+        std::vector<uint32_t> group_size(ids.size(), 0);
+        size_t largest = 0;
+        size_t merged = 0;
+        for(size_t i = 0; i < middle; ++i)
+        {
+            if(group_of[i] != none)
             {
-                if(--remaining_merges == 0)
-                    break;
+                largest = std::max(largest, size_t(++group_size[groups.find_update(group_of[i])]));
+                ++merged;
             }
         }
-        builder.remove();
+        // one subtree takes most of the round, the rest is merged serially
+        if(largest > merged/2)
+            break;
+        std::vector<uint32_t> task_of(ids.size(), none);
+        std::vector<std::vector<size_t>> tasks;
+        size_t filled = task_size;
+        for(size_t i = 0; i < middle; ++i)
+        {
+            if(group_of[i] == none)
+                continue;
+            uint32_t const g = groups.find_update(group_of[i]);
+            if(task_of[g] == none)
+            {
+                if(filled >= task_size)
+                {
+                    tasks.emplace_back();
+                    filled = 0;
+                }
+                task_of[g] = uint32_t(tasks.size()-1);
+                filled += group_size[g];
+            }
+            tasks[task_of[g]].push_back(i);
+        }
+
+        // zip groups up to bound
+        boost::mutex locks[Boundary::lock_count];
+        std::vector<Boundary> boundaries(tasks.size(), Boundary(locks));
+        std::deque<ThreadBuilder<B>> builders;
+        for(size_t t = 0; t < tasks.size(); ++t)
+        {
+            builders.emplace_back(builder.builder());
+            // a merge creates one component at most
+            builder.lend(builders.back(), size_type(tasks[t].size()), bound);
+        }
+        auto run = [&](size_t t)
+        {
+            for(size_t i : tasks[t])
+            {
+                Pending const & e = pending[i];
+                builders[t].merge_paths_below(
+                    leafId(e.edge.points[0]), e.tops[0], leafId(e.edge.points[1]), e.tops[1],
+                    e.edge, bound, boundaries[t]);
+            }
+        };
+        {
+            utils::TaskGroup group(pool);
+            for(size_t t = 1; t < tasks.size(); ++t)
+            {
+                group.run([&, t]() { run(t); });
+            }
+            if(!tasks.empty())
+                run(0);
+            group.wait();
+        }
+        for(auto & b : builders)
+        {
+            builder.absorb(std::move(b));
+        }
+
+        // cut links, lowest parents first, so empty ones are removed before their parents
+        auto later = [](Cut const & x, Cut const & y)
+        {
+            return (*y.first < *x.first) ||
+                (!(*x.first < *y.first) && std::less<Component *>()(y.first, x.first));
+        };
+        std::vector<Cut> cuts;
+        for(auto const & b : boundaries)
+        {
+            cuts.insert(cuts.end(), b.cuts().begin(), b.cuts().end());
+        }
+        std::priority_queue<Cut, std::vector<Cut>, decltype(later)> queue(later, std::move(cuts));
+        std::vector<Pending> links;
+        while(!queue.empty())
+        {
+            Component * const parent = queue.top().first;
+            size_type const leaf = queue.top().second;
+            // join cut leaves to a leaf still below the parent, or to the first one
+            bool const empty = parent->empty();
+            size_type anchor = leaf;
+            if(!empty)
+            {
+                Node const * n = &*parent->begin();
+                while(!builder.tree().isNodeLeaf(*n))
+                {
+                    n = &*static_cast<Component const *>(n)->begin();
+                }
+                anchor = builder.tree().leafId(static_cast<Leaf const &>(*n));
+            }
+            Pending link;
+            link.edge.points[1] = point(anchor);
+            link.edge.weight = Weight(parent->level());
+            link.tops[0] = link.tops[1] = nullptr;
+            for(; !queue.empty() && (queue.top().first == parent); queue.pop())
+            {
+                // links to the root change nothing
+                if((queue.top().second != anchor) && parent->parent())
+                {
+                    link.edge.points[0] = point(queue.top().second);
+                    links.push_back(link);
+                }
+            }
+            if(empty)
+            {
+                // leaf takes the place of removed parent in the grandparent
+                Component * p = builder.erase(parent);
+                BOOST_ASSERT(p);
+                queue.push(Cut(p, leaf));
+            }
+        }
+        std::sort(links.begin(), links.end(), lower);
+        std::vector<Pending> rest(links.size() + (pending.size()-middle));
+        std::merge(pending.begin()+middle, pending.end(), links.begin(), links.end(),
+            rest.begin(), lower);
+        pending.swap(rest);
+        // subtrees up to bound do not change anymore
+        findTops(pending.data(), pending.size(), bound);
+    }
+    for(Pending const & e : pending)
+    {
+        if(!joined(e))
+        {
+            builder.merge_paths(
+                leafId(e.edge.points[0]), e.tops[0], leafId(e.edge.points[1]), e.tops[1], e.edge);
+        }
+    }
+}
+
+template<
+    typename T,
+    typename B,
+    typename WeightFunction
+    >
+void buildAlphaTree(
+    cv::Size_<T> const & size,
+    cv::Size_<T> const & tile,
+    ThreadBuilder<B> & builder,
+    WeightFunction e,
+    unsigned treeDepth,
+    cv::Rect_<T> const & rect
+)
+{
+    typedef cv::Point_<T> Point;
+    typedef decltype(e(Point(),Point())) Weight;
+    typedef Edge<T, Weight> Edge;
+
+    if(treeDepth == 0)
+    {
+        buildAlphaTreeTile(size, tile, builder, e, rect);
     }
     else
     {
-        size_t count;
         cv::Rect_<T> ra;
         cv::Rect_<T> rb;
         if(rect.width > rect.height)
         {
             // split vertically
-            count = rect.height;
             T w2 = rect.width/2;
             ra = cv::Rect_<T>(rect.x, rect.y, w2, rect.height);
             rb = cv::Rect_<T>(rect.x+w2, rect.y, rect.width-w2, rect.height);
@@ -99,42 +509,26 @@ void buildAlphaTree(
         else
         {
             // split horizontally
-            count = rect.width;
             T h2 = rect.height/2;
             ra = cv::Rect_<T>(rect.x, rect.y, rect.width, h2);
             rb = cv::Rect_<T>(rect.x, rect.y+h2, rect.width, rect.height-h2);
         }
-        // build partial trees
+        Seam<T> const seam(ra, rb);
+        utils::ThreadPool & pool = utils::ThreadPool::global();
+        // build partial trees, second half is a task of the thread pool
         ThreadBuilder<B> thread_builder(builder.builder());
-        // spawn thread, TODO : copy everything to its stack
-        boost::thread task([&]()
+        utils::TaskGroup task(pool);
+        task.run([&]()
         {
             buildAlphaTree(size, tile, thread_builder, e, treeDepth-1, rb);
         });
         buildAlphaTree(size, tile, builder, e, treeDepth-1, ra);
         // extract connecting edges
-        std::vector<Edge> edges(count);
-        if(rect.width > rect.height)
-        {
-            count = getSortedHorizontalConnectors(Point(rect.x+rect.width/2-1, rect.y), rect.height, &edges[0], e);
-        }
-        else
-        {
-            count = getSortedVerticalConnectors(Point(rect.x, rect.y+rect.height/2-1), rect.width, &edges[0], e);
-        }
-        // merge trees
-        task.join();
-        builder.absorb(std::move(thread_builder));
-        for(size_t i = 0; i < count; ++i)
-        {
-            Edge const & edge = edges[i];
-            auto a = pointId(edge.points[0], size);
-            auto b = pointId(edge.points[1], size);
-            Component * n = builder.merge_roots(a, b, edge);
-            if(*n <= edge)
-                break;//continue;
-            builder.merge_paths(a, b, edge);
-        }
+        std::vector<Edge> edges;
+        size_t const count = getSortedSeam(seam, e, edges);
+        // merge trees, help with other tasks while waiting
+        task.wait();
+        mergeSeam(size, builder, std::move(thread_builder), edges.data(), count, pool);
     }
 }
 
@@ -151,6 +545,8 @@ void buildAlphaTree(
     unsigned depth
 )
 {
+    // one builder for every split
+    builder.reserveBuilders(typename Builder::size_type(1) << std::min(depth, 30u));
     ThreadBuilder<Builder> thread_builder(builder);
     buildAlphaTree(size, tile, thread_builder, e, depth,
         cv::Rect_<T>(0, 0, size.width, size.height)
@@ -158,166 +554,202 @@ void buildAlphaTree(
     builder.finish(std::move(thread_builder));
 }
 
-#if 0
+// Pixel rectangle of tiles [cells.x, cells.x+cells.width[ x [cells.y, cells.y+cells.height[
+template<typename T>
+cv::Rect_<T> gridRect(
+    cv::Size_<T> const & size,
+    cv::Size_<T> const & grid,
+    cv::Rect_<T> const & cells
+)
+{
+    auto x = [&](T i) { return T(size_t(i)*size.width/grid.width); };
+    auto y = [&](T j) { return T(size_t(j)*size.height/grid.height); };
+    T const x0 = x(cells.x);
+    T const y0 = y(cells.y);
+    return cv::Rect_<T>(x0, y0, x(cells.x+cells.width)-x0, y(cells.y+cells.height)-y0);
+}
+
 template<
     typename T,
-    typename Builder,
+    typename B,
     typename WeightFunction
     >
-typename Builder::Roots
-buildAlphaTreeNomerge(
+void buildAlphaTree(
     cv::Size_<T> const & size,
     cv::Size_<T> const & tile,
-    Builder & builder,
+    ThreadBuilder<B> & builder,
     WeightFunction e,
-    unsigned treeDepth,
-    cv::Rect_<T> const & rect
+    cv::Size_<T> const & grid,
+    cv::Rect_<T> const & cells,
+    utils::ThreadPool & pool
 )
 {
     typedef cv::Point_<T> Point;
     typedef decltype(e(Point(),Point())) Weight;
     typedef Edge<T, Weight> Edge;
-    typedef typename Builder::Roots Roots;
-
-    Roots roots;
 
-    if(treeDepth == 0)
+    cv::Rect_<T> const rect = gridRect(size, grid, cells);
+    if((cells.width == 1) && (cells.height == 1))
     {
-        size_t ec = edgeCount(rect.size());
-        //std::unique_ptr<Edge[]> edges(new Edge[ec]);
-        std::vector<Edge> edges(ec);
-        size_t count = getSortedImageEdges(rect, tile, &edges[0], e);
-        //std::/*stable_*/sort(edges.get(), edges.get()+count);
-        BOOST_ASSERT(count == ec);
-
-        typename Builder::Components pool;
-        typename Builder::Components toDelete;
-
-        Weight lastWeight = edges[0].weight;
-        for(size_t i = 0; i < count; ++i)
-        {
-            if(lastWeight < edges[i].weight)
-            {
-                builder.removeTopLayerComponents(toDelete);
-                pool.splice(pool.begin(), toDelete);
-                lastWeight = edges[i].weight;
-            }
-            builder.addEdge(
-                cct::pointId(edges[i].points[0], size),
-                cct::pointId(edges[i].points[1], size),
-                edges[i], roots, toDelete, pool
-            );
-        }
-        builder.removeTopLayerComponents(toDelete);
-        pool.splice(pool.begin(), toDelete);
-        builder.deleteNodes(std::move(pool));
+        buildAlphaTreeTile(size, tile, builder, e, rect);
+        return;
+    }
+    // split tiles in halves across the longer side of the rectangle
+    cv::Rect_<T> ca = cells;
+    cv::Rect_<T> cb = cells;
+    if((cells.height == 1) || ((cells.width > 1) && (rect.width > rect.height)))
+    {
+        ca.width = cells.width/2;
+        cb.x += ca.width;
+        cb.width -= ca.width;
     }
     else
     {
-        Roots threadRoots;
-        //std::unique_ptr<Edge[]> edges;
-        std::vector<Edge> edges;
-        size_t count;
-        if(rect.width > rect.height)
-        {
-            count = rect.height;
-            // split vertically
-            T w2 = rect.width/2;
-            //auto task = boost::async(boost::launch::any, [&]()
-            boost::thread task([&]()
-            {
-                threadRoots = buildAlphaTreeNomerge(
-                    size, tile, builder, e, treeDepth-1,
-                    cv::Rect_<T>(rect.x+w2, rect.y, rect.width-w2, rect.height)
-                );
-            });
-            roots = buildAlphaTreeNomerge(
-                size, tile, builder, e, treeDepth-1,
-                cv::Rect_<T>(rect.x, rect.y, w2, rect.height)
-            );
-            // get connecting edges
-            //edges.reset(new Edge[count]);
-            edges.resize(count);
-            getHorizontalConnectors(Point(rect.x+w2-1, rect.y), rect.height, &edges[0], e);
-            //std::sort(edges.get(), edges.get()+count);
-            // wait for the second part of the tree
-            //task.get();
-            task.join();
-        }
-        else
+        ca.height = cells.height/2;
+        cb.y += ca.height;
+        cb.height -= ca.height;
+    }
+    Seam<T> const seam(gridRect(size, grid, ca), gridRect(size, grid, cb));
+    // build partial trees, second half is a task of the thread pool
+    ThreadBuilder<B> thread_builder(builder.builder());
+    utils::TaskGroup task(pool);
+    task.run([&]()
+    {
+        buildAlphaTree(size, tile, thread_builder, e, grid, cb, pool);
+    });
+    buildAlphaTree(size, tile, builder, e, grid, ca, pool);
+    // extract connecting edges
+    std::vector<Edge> edges;
+    size_t const count = getSortedSeam(seam, e, edges);
+    // merge trees, help with other tasks while waiting
+    task.wait();
+    mergeSeam(size, builder, std::move(thread_builder), edges.data(), count, pool);
+}
+
+template<
+    typename T,
+    typename Builder,
+    typename EdgeWeightFunction
+>
+void buildAlphaTree(
+    cv::Size_<T> const & size,
+    cv::Size_<T> const & tile,
+    Builder & builder,
+    EdgeWeightFunction e,
+    cv::Size_<T> const & grid,
+    utils::ThreadPool & pool
+)
+{
+    BOOST_ASSERT((grid.width > 0) && (grid.width <= size.width));
+    BOOST_ASSERT((grid.height > 0) && (grid.height <= size.height));
+    // one builder for every split
+    builder.reserveBuilders(typename Builder::size_type(grid.width)*grid.height);
+    ThreadBuilder<Builder> thread_builder(builder);
+    buildAlphaTree(size, tile, thread_builder, e, grid,
+        cv::Rect_<T>(0, 0, grid.width, grid.height), pool
+    );
+    builder.finish(std::move(thread_builder));
+}
+
+template<
+    typename T,
+    typename Builder,
+    typename EdgeWeightFunction,
+    typename Edge
+>
+size_t buildAlphaTreeNomerge(
+    cv::Size_<T> const & size,
+    cv::Size_<T> const & tile,
+    Builder & builder,
+    EdgeWeightFunction e,
+    cv::Size_<T> const & grid,
+    std::vector<Edge> & connectors,
+    utils::ThreadPool & pool
+)
+{
+    typedef cv::Point_<T> Point;
+
+    BOOST_ASSERT((grid.width > 0) && (grid.width <= size.width));
+    BOOST_ASSERT((grid.height > 0) && (grid.height <= size.height));
+    // every tile has its own builder, they share only the arena of the tree
+    builder.reserveBuilders(typename Builder::size_type(grid.width)*grid.height);
+    std::vector<std::unique_ptr<ThreadBuilder<Builder>>> builders;
+    utils::TaskGroup group(pool);
+    for(T j = 0; j < grid.height; ++j)
+    {
+        for(T i = 0; i < grid.width; ++i)
         {
-            count = rect.width;
-            // split horizontally
-            T h2 = rect.height/2;
-            //auto task = boost::async(boost::launch::any, [&]()
-            boost::thread task([&]()
+            builders.emplace_back(new ThreadBuilder<Builder>(builder));
+            ThreadBuilder<Builder> * tb = builders.back().get();
+            cv::Rect_<T> const rect = gridRect(size, grid, cv::Rect_<T>(i, j, 1, 1));
+            group.run([&, tb, rect]()
             {
-                threadRoots = buildAlphaTreeNomerge(
-                    size, tile, builder, e, treeDepth-1,
-                    cv::Rect_<T>(rect.x, rect.y+h2, rect.width, rect.height-h2)
-                );
+                buildAlphaTreeTile(size, tile, *tb, e, rect);
             });
-            roots = buildAlphaTreeNomerge(
-                size, tile, builder, e, treeDepth-1,
-                cv::Rect_<T>(rect.x, rect.y, rect.width, h2)
-            );
-            // get connecting edges
-            //edges.reset(new Edge[count]);
-            edges.resize(count);
-            getVerticalConnectors(Point(rect.x, rect.y+h2-1), rect.width, &edges[0], e);
-            //std::sort(edges.get(), edges.get()+count);
-            // wait for the second part of the tree
-            //task.get();
-            task.join();
         }
-        roots.add(std::move(threadRoots));
-        //pruneAlphaTree(size, builder, edges.get(), count, roots);
-        //for(size_t i = 0; i < count; ++i)
-        //{
-        //    builder.pruneForest(
-        //        cct::pointId(edges[i].points[0], size),
-        //        cct::pointId(edges[i].points[1], size),
-        //        edges[i], roots
-        //        );
-        //}
     }
-    return roots;
+    // extract connecting edges meanwhile, horizontal edges of inner columns first
+    connectors.resize(size_t(grid.width-1)*size.height + size_t(grid.height-1)*size.width);
+    size_t count = 0;
+    for(T i = 1; i < grid.width; ++i)
+    {
+        T const x = gridRect(size, grid, cv::Rect_<T>(i, 0, 1, 1)).x;
+        count += getHorizontalConnectors(Point(x-1, 0), size.height, &connectors[count], e);
+    }
+    for(T j = 1; j < grid.height; ++j)
+    {
+        T const y = gridRect(size, grid, cv::Rect_<T>(0, j, 1, 1)).y;
+        count += getVerticalConnectors(Point(0, y-1), size.width, &connectors[count], e);
+    }
+    connectors.resize(count);
+    std::stable_sort(connectors.begin(), connectors.end());
+    // help with tiles, then move tile roots to the tree
+    group.wait();
+    for(auto & tb : builders)
+    {
+        builder.finish(std::move(*tb));
+    }
+    return count;
 }
+
 template<
     typename T,
     typename Builder,
-    typename WeightFunction
-    >
-void buildAlphaTreeNomerge(
-        cv::Size_<T> const & size,
-        cv::Size_<T> const & tile,
-        Builder & builder,
-        WeightFunction e,
-        unsigned depth
-        )
+    typename Edge
+>
+void mergeForest(
+    cv::Size_<T> const & size,
+    Builder & builder,
+    std::vector<Edge> const & connectors
+)
 {
-    //builder.finish(
-    //    buildAlphaTreeNomerge(
-    //        size, tile, builder, e, depth,
-    //        cv::Rect_<T>(0, 0, size.width, size.height)
-    //        )
-    //);
-}
-#endif
+    typedef typename Builder::size_type size_type;
 
+    ThreadBuilder<Builder> tb(builder);
+    tb.adopt();
+    for(Edge const & edge : connectors)
+    {
+        size_type const a = size_type(pointId(edge.points[0], size));
+        size_type const b = size_type(pointId(edge.points[1], size));
+        // trees may join below the edge already
+        if(!(*tb.merge_roots(a, b, edge) <= edge))
+            tb.merge_paths(a, b, edge);
+    }
+    builder.finish(std::move(tb));
+}
 
-/*
-template<typename T,
+template<
+    typename T,
     typename Builder,
     typename VertexWeightFunction,
     typename EdgeWeightFunction
-    >
+>
 void buildSecondOrderTree(
-        cv::Rect_<T> const & rect,
-        Builder & builder,
-        VertexWeightFunction v,
-        EdgeWeightFunction e
-        )
+    cv::Size_<T> const & size, cv::Size_<T> const & tile,
+    Builder & builder,
+    VertexWeightFunction v,
+    EdgeWeightFunction e
+)
 {
     typedef cv::Point_<T> Point;
     typedef decltype(v(Point())) VertexWeight;
@@ -325,38 +757,38 @@ void buildSecondOrderTree(
     typedef decltype(e(Point(),Point())) EdgeWeight;
     typedef Edge<T, EdgeWeight> Edge;
 
-    size_t vc = vertexCount(rect.size());
-    size_t ec = edgeCount(rect.size());
-    std::unique_ptr<Vertex[]> vertices(new Vertex[vc]);
-    std::unique_ptr<Edge[]> edges(new Edge[ec]);
-    getImageGraph(rect, vertices.get(), edges.get(), v, e);
+    cv::Rect_<T> const rect(0, 0, size.width, size.height);
+
+    std::vector<Vertex> vertices(vertexCount(size));
+    size_t const vertex_count = getSortedImageVertices(rect, &vertices[0], v);
+    std::vector<Edge> edges(edgeCount(size));
+    size_t const edge_count = getSortedImageEdges(rect, tile, &edges[0], e);
+
+    ThreadBuilder<Builder> thread_builder(builder);
 
-    EdgeWeight lastWeight = edges[0].weight;
-    for(size_t vi = 0, ei = 0; (vi < vc) && (ei < ec);)
+    size_t vi = 0;
+    for(size_t ei = 0; ei < edge_count; ++ei)
     {
-        if(vertices[vi].weight < edges[ei].weight)
+        // vertices up to the edge level
+        while((vi < vertex_count) && !(edges[ei].weight < vertices[vi].weight))
         {
-            builder.addVertex(
-                cct::pointId(vertices[vi].point, rect),
-                vertices[vi]
-                );
+            thread_builder.addVertex(pointId(vertices[vi].point, size), vertices[vi]);
             ++vi;
         }
-        else
+        if((ei > 0) && (edges[ei-1].weight < edges[ei].weight))
         {
-            if(lastWeight < edges[ei].weight)
-            {
-                lastWeight = edges[ei].weight;
-                builder.prune();
-            }
-            builder.addEdge(
-                    cct::pointId(edges[ei].points[0], rect),
-                    cct::pointId(edges[ei].points[1], rect),
-                    edges[ei]
-                    );
-            ++ei;
+            thread_builder.remove();
         }
+        thread_builder.addEdge(
+            pointId(edges[ei].points[0], size),
+            pointId(edges[ei].points[1], size),
+            edges[ei]
+        );
     }
-    builder.prune();
-};
-*/
+    // vertices above all edges
+    for(; vi < vertex_count; ++vi)
+    {
+        thread_builder.addVertex(pointId(vertices[vi].point, size), vertices[vi]);
+    }
+    builder.finish(std::move(thread_builder));
+}
@@ -0,0 +1,517 @@
+#ifndef CONNECTED_COMPONENT_TREE_INDEX_NODE_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_INDEX_NODE_H_INCLUDED
+
+#include "utils/tagged_ptr.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include <iterator>
+#include <limits>
+#include <ostream>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+class IndexNodeBase;
+struct IndexLeafBase;
+struct IndexComponentBase;
+
+class IndexPointerHead;
+
+template<typename T, typename Head = IndexPointerHead>
+class IndexList;
+
+/** \brief 32 bit links between nodes.
+ *
+ * A link is the distance from the node holding it to the linked node,
+ * in units of node alignment.
+ * All nodes of a tree live in one memory block (see Tree),
+ * so links are indices into the node array, relative to the holder.
+ * They need no base pointer and stay valid as long as nodes are not moved.
+ */
+namespace index_link {
+
+constexpr size_t UNIT = 4;
+
+typedef int32_t Offset;
+
+// 0 is a link to self, e.g. the only node of a list is its own last node
+constexpr Offset NONE = std::numeric_limits<Offset>::min();
+
+template<typename T>
+inline Offset make(void const * from, T const * to) noexcept
+{
+    if(!to)
+        return NONE;
+    std::ptrdiff_t const bytes = std::ptrdiff_t(utils::p2u(to)) - std::ptrdiff_t(utils::p2u(from));
+    BOOST_ASSERT(bytes % std::ptrdiff_t(UNIT) == 0);
+    std::ptrdiff_t const d = bytes / std::ptrdiff_t(UNIT);
+    BOOST_ASSERT(d > NONE);
+    BOOST_ASSERT(d <= std::numeric_limits<Offset>::max());
+    return Offset(d);
+}
+
+template<typename T>
+inline T * get(void const * from, Offset o) noexcept
+{
+    return (o != NONE) ? utils::u2p<T>(utils::p2u(from) + std::uintptr_t(std::ptrdiff_t(o)*std::ptrdiff_t(UNIT))) : nullptr;
+}
+
+}//namespace index_link
+
+/** \brief First node of IndexList stored as a link, for lists inside nodes. */
+class IndexLinkHead
+{
+    index_link::Offset m_first;
+protected :
+    IndexLinkHead() noexcept
+        : m_first(index_link::NONE) {}
+
+    IndexNodeBase * first() const noexcept
+    {
+        return index_link::get<IndexNodeBase>(this, m_first);
+    }
+    void first(IndexNodeBase * node) noexcept
+    {
+        m_first = index_link::make(this, node);
+    }
+};
+
+/** \brief First node of IndexList stored as a pointer, for lists outside of node memory. */
+class IndexPointerHead
+{
+    IndexNodeBase * m_first;
+protected :
+    IndexPointerHead() noexcept
+        : m_first(nullptr) {}
+
+    IndexNodeBase * first() const noexcept
+    {
+        return m_first;
+    }
+    void first(IndexNodeBase * node) noexcept
+    {
+        m_first = node;
+    }
+};
+
+/** Base class for both index linked tree nodes.
+ *
+ * Alternative to NodeBase with 32 bit links instead of pointers :
+ *  parent (with leaf/component tag in the lowest bit), next and previous sibling
+ * 12 bytes instead of 24 on 64b systems.
+ * Nodes must be allocated by Tree, in its node memory.
+ *
+ * \section nodes
+ */
+class alignas(index_link::UNIT) IndexNodeBase
+{
+    template<typename T, typename Head>
+    friend class IndexList;
+
+    // link*2 + tag, 0 is null (parent is never self)
+    int32_t m_parent;
+    // siblings in child list of parent or in a list of roots
+    index_link::Offset m_next;
+    index_link::Offset m_prev;
+
+    IndexNodeBase * next() const noexcept
+    {
+        return index_link::get<IndexNodeBase>(this, m_next);
+    }
+    IndexNodeBase * prev() const noexcept
+    {
+        return index_link::get<IndexNodeBase>(this, m_prev);
+    }
+    void setNext(IndexNodeBase * node) noexcept
+    {
+        m_next = index_link::make(this, node);
+    }
+    void setPrev(IndexNodeBase * node) noexcept
+    {
+        m_prev = index_link::make(this, node);
+    }
+public :
+    typedef IndexNodeBase Node;
+
+    typedef uint32_t Tag;
+
+    typedef uint32_t size_type;
+
+    /** \brief Lists of nodes outside of the tree, e.g. roots. */
+    template<typename T, bool ConstantTimeSize>
+    using List = IndexList<T>;
+
+    /** \brief Nodes must be in one memory block of the tree. */
+    static constexpr bool contiguous_storage = true;
+
+    /** \brief Span of node memory reachable by parent links. */
+    static constexpr size_t max_storage_size = size_t(1) << 32;
+
+    /** \brief Default constructor. parent=nullptr, tag=0 */
+    IndexNodeBase() noexcept
+        : m_parent(0), m_next(index_link::NONE), m_prev(index_link::NONE) {}
+
+    explicit IndexNodeBase(Tag tag) noexcept
+        : m_parent(int32_t(tag & 1)), m_next(index_link::NONE), m_prev(index_link::NONE) {}
+
+    // Node is noncopyable
+    IndexNodeBase(Node const &) = delete;
+    IndexNodeBase & operator=(Node const &) = delete;
+
+    /** Returns parent node.
+     * root -> nullptr
+     */
+    IndexComponentBase       * parent()       noexcept
+    {
+        index_link::Offset const o = (m_parent - int32_t(tag()))/2;
+        return o ? index_link::get<IndexComponentBase>(this, o) : nullptr;
+    }
+    IndexComponentBase const * parent() const noexcept
+    {
+        index_link::Offset const o = (m_parent - int32_t(tag()))/2;
+        return o ? index_link::get<IndexComponentBase const>(this, o) : nullptr;
+    }
+
+    /**
+     * tag == 0 -> leaf
+     * tag != 0 -> component
+     */
+    Tag tag() const noexcept
+    {
+        return uint32_t(m_parent) & 1;
+    }
+
+    bool isLeaf() const noexcept
+    {
+        return tag() == 0;
+    }
+    bool isComponent() const noexcept
+    {
+        return tag() != 0;
+    }
+
+    /** \brief Set new parent node. */
+    void setParent(IndexComponentBase * node) noexcept;
+
+    /** \brief Traverse up, return node with parent == nullptr. */
+    IndexComponentBase * root() noexcept;
+
+    /** \brief Unlink a node from its parent
+     * postconditions :
+     *  parent() == nullptr
+     * returns :
+     *  previous parent (or nullptr)
+     */
+    IndexComponentBase * unlink() noexcept;
+
+    /** Is a node ancestor of *this?
+     */
+    bool isLinkedTo(IndexComponentBase const * ancestor) const noexcept;
+};
+
+/** Base class of index linked leaf nodes.
+ * \section nodes
+ */
+struct IndexLeafBase
+    : public IndexNodeBase
+{
+    typedef typename IndexNodeBase::size_type size_type;
+
+    ~IndexLeafBase() noexcept
+    {
+        // Tag is intact
+        BOOST_ASSERT(isLeaf());
+    }
+
+    /** \brief Traverse tree and calculate height.
+     *
+     * O(tree_height)
+     */
+    size_type calculateHeight() const noexcept;
+};
+
+/** \brief Intrusive list over sibling links of IndexNodeBase.
+ *
+ * Subset of boost::intrusive::list used by Tree and ThreadBuilder.
+ * The list is null terminated, prev of the first node is the last node,
+ * so both ends are O(1) and end() is a null iterator,
+ * which stays valid while nodes are spliced away.
+ * A node is in at most one list : child list of its parent or a list of roots.
+ *
+ * Lists are noncopyable, IndexLinkHead lists must not be moved.
+ */
+template<typename T, typename Head>
+class IndexList
+    : private Head
+{
+public :
+    typedef uint32_t size_type;
+
+    template<typename V>
+    class Iterator
+        : public std::iterator<std::forward_iterator_tag, V>
+    {
+        friend class IndexList;
+        template<typename U>
+        friend class Iterator;
+
+        V * m_node;
+    public :
+        explicit Iterator(V * node = nullptr) noexcept
+            : m_node(node) {}
+
+        // iterator -> const_iterator
+        template<typename U>
+        Iterator(Iterator<U> const & i) noexcept
+            : m_node(i.m_node) {}
+
+        V & operator*() const noexcept
+        {
+            return *m_node;
+        }
+        V * operator->() const noexcept
+        {
+            return m_node;
+        }
+        Iterator & operator++() noexcept
+        {
+            m_node = static_cast<V *>(m_node->next());
+            return *this;
+        }
+        Iterator operator++(int) noexcept
+        {
+            Iterator i = *this;
+            ++(*this);
+            return i;
+        }
+        bool operator==(Iterator const & i) const noexcept
+        {
+            return m_node == i.m_node;
+        }
+        bool operator!=(Iterator const & i) const noexcept
+        {
+            return m_node != i.m_node;
+        }
+    };
+
+    typedef Iterator<T> iterator;
+    typedef Iterator<T const> const_iterator;
+private :
+    typedef IndexNodeBase Node;
+
+    size_type m_size;
+
+    Node * last() const noexcept
+    {
+        Node * f = Head::first();
+        return f ? f->prev() : nullptr;
+    }
+
+    // link chain [a, b] before pos, nullptr is end
+    void link(Node * pos, Node * a, Node * b) noexcept;
+
+    // unlink chain [a, b]
+    void unlink(Node * a, Node * b) noexcept;
+public :
+    IndexList() noexcept
+        : m_size(0) {}
+
+    IndexList(IndexList const &) = delete;
+    IndexList & operator=(IndexList const &) = delete;
+
+    bool empty() const noexcept
+    {
+        return !Head::first();
+    }
+    size_type size() const noexcept
+    {
+        return m_size;
+    }
+
+    iterator begin() noexcept
+    {
+        return iterator(static_cast<T *>(Head::first()));
+    }
+    iterator end() noexcept
+    {
+        return iterator();
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(static_cast<T const *>(Head::first()));
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator();
+    }
+
+    T & front() noexcept
+    {
+        BOOST_ASSERT(!empty());
+        return *begin();
+    }
+
+    iterator iterator_to(T & node) noexcept
+    {
+        return iterator(&node);
+    }
+    const_iterator iterator_to(T const & node) const noexcept
+    {
+        return const_iterator(&node);
+    }
+
+    void push_front(T & node) noexcept
+    {
+        link(Head::first(), &node, &node);
+        ++m_size;
+    }
+    void push_back(T & node) noexcept
+    {
+        link(nullptr, &node, &node);
+        ++m_size;
+    }
+    void pop_front() noexcept
+    {
+        erase(begin());
+    }
+
+    /** \returns iterator to the next node */
+    iterator erase(iterator i) noexcept
+    {
+        Node * node = i.m_node;
+        iterator next(static_cast<T *>(node->next()));
+        unlink(node, node);
+        --m_size;
+        return next;
+    }
+
+    /** \brief Move all nodes of other before pos. O(1) */
+    void splice(iterator pos, IndexList & other) noexcept;
+
+    /** \brief Move nodes [f, l[ of other before pos. O(l-f) */
+    void splice(iterator pos, IndexList & other, iterator f, iterator l) noexcept;
+
+    /** \brief Forget all nodes, they are not unlinked. O(1)
+     *
+     * Nodes must be dropped or constructed again.
+     */
+    void clear() noexcept
+    {
+        Head::first(nullptr);
+        m_size = 0;
+    }
+};
+
+/** Base class of index linked inner nodes.
+ *
+ * Child list is a link to the first child and a 32 bit child count,
+ * 20 bytes per component instead of 48.
+ *
+ * \section nodes
+ */
+struct IndexComponentBase
+    : public IndexNodeBase
+{
+    static constexpr bool constant_time_children_size = true;
+
+    typedef typename IndexNodeBase::size_type size_type;
+
+    typedef IndexList<Node, IndexLinkHead> Children;
+
+    //list is partially sorted, so leaves are after internal nodes
+    Children children;
+public :
+    typedef typename Children::      iterator       iterator;
+    typedef typename Children::const_iterator const_iterator;
+
+    bool empty() const noexcept
+    {
+        return children.empty();
+    }
+
+    /** O(1) */
+    size_type size() const noexcept
+    {
+        return children.size();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return children.begin();
+    }
+    const_iterator end() const noexcept
+    {
+        return children.end();
+    }
+    iterator begin() noexcept
+    {
+        return children.begin();
+    }
+    iterator end() noexcept
+    {
+        return children.end();
+    }
+
+    IndexComponentBase() noexcept
+        : IndexNodeBase(1) {}
+
+    ~IndexComponentBase() noexcept
+    {
+        // Tag is intact
+        BOOST_ASSERT(isComponent());
+        // Child list must be empty when destroyed
+        BOOST_ASSERT(empty());
+    }
+
+    /** Node is degenerate if it has 0 or 1 children.
+     */
+    bool isDegenerate() const noexcept
+    {
+        return size() < 2;
+    }
+
+    /** \brief Link leaf to parent(this)
+     * preconditions :
+     *  parent() == nullptr
+     * postconditions :
+     *  leaf is linked to <this>
+     */
+    void link(IndexLeafBase * leaf) noexcept;
+
+    /** see link(Leaf *)
+     */
+    void link(IndexComponentBase * node) noexcept;
+
+    /** Unlink node and link to new parent(this)
+     * postconditions :
+     *  child is linked to parent
+     * \return previous parent
+     */
+    template<typename Child>
+    IndexComponentBase * relink(Child * child) noexcept;
+
+    /** \brief Reconnect children of node to this */
+    void absorb(IndexComponentBase & node) noexcept;
+};
+
+static_assert(sizeof(IndexLeafBase) == 12, "Unexpected index leaf size");
+static_assert(sizeof(IndexComponentBase) == 20, "Unexpected index component size");
+
+inline std::ostream & operator<<(std::ostream & o, IndexComponentBase const &)
+{
+    return o;
+}
+inline std::ostream & operator<<(std::ostream & o, IndexLeafBase const &)
+{
+    return o;
+}
+
+//implementations are in separate file
+#include "index_node.inl"
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_INDEX_NODE_H_INCLUDED
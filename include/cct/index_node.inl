@@ -0,0 +1,217 @@
+//---------------------
+// List stuff
+//--------------------
+
+template<typename T, typename Head>
+inline void IndexList<T, Head>::link(Node * pos, Node * a, Node * b) noexcept
+{
+    Node * f = Head::first();
+    if(!f)
+    {
+        Head::first(a);
+        a->setPrev(b);
+        b->setNext(nullptr);
+    }
+    else if(!pos)
+    {
+        Node * l = f->prev();
+        l->setNext(a);
+        a->setPrev(l);
+        b->setNext(nullptr);
+        f->setPrev(b);
+    }
+    else if(pos == f)
+    {
+        a->setPrev(f->prev());
+        b->setNext(f);
+        f->setPrev(b);
+        Head::first(a);
+    }
+    else
+    {
+        Node * p = pos->prev();
+        p->setNext(a);
+        a->setPrev(p);
+        b->setNext(pos);
+        pos->setPrev(b);
+    }
+}
+
+template<typename T, typename Head>
+inline void IndexList<T, Head>::unlink(Node * a, Node * b) noexcept
+{
+    Node * f = Head::first();
+    Node * n = b->next();
+    if(a == f)
+    {
+        // n is the new first node, it takes over the link to the last one
+        if(n)
+            n->setPrev(f->prev());
+        Head::first(n);
+    }
+    else
+    {
+        Node * p = a->prev();
+        p->setNext(n);
+        if(n)
+            n->setPrev(p);
+        else
+            f->setPrev(p);
+    }
+    a->setPrev(nullptr);
+    b->setNext(nullptr);
+}
+
+template<typename T, typename Head>
+inline void IndexList<T, Head>::splice(iterator pos, IndexList & other) noexcept
+{
+    if(other.empty())
+        return;
+    Node * a = other.first();
+    Node * b = other.last();
+    size_type const n = other.m_size;
+    other.clear();
+    link(pos.m_node, a, b);
+    m_size += n;
+}
+
+template<typename T, typename Head>
+inline void IndexList<T, Head>::splice(iterator pos, IndexList & other, iterator f, iterator l) noexcept
+{
+    if(f == l)
+        return;
+    Node * a = f.m_node;
+    Node * b = a;
+    size_type n = 1;
+    while(b->next() != l.m_node)
+    {
+        b = b->next();
+        ++n;
+    }
+    other.unlink(a, b);
+    other.m_size -= n;
+    link(pos.m_node, a, b);
+    m_size += n;
+}
+
+//---------------------
+// Node stuff
+//--------------------
+
+inline void IndexNodeBase::setParent(IndexComponentBase * node) noexcept
+{
+    index_link::Offset o = 0;
+    if(node)
+    {
+        o = index_link::make(this, node);
+        BOOST_ASSERT(o != 0);
+        BOOST_ASSERT(o >= std::numeric_limits<int32_t>::min()/2);
+        BOOST_ASSERT(o <= std::numeric_limits<int32_t>::max()/2);
+    }
+    m_parent = o*2 + int32_t(tag());
+}
+
+inline IndexComponentBase * IndexNodeBase::root() noexcept
+{
+    IndexComponentBase * n = parent();
+    if(n)
+    {
+        IndexComponentBase * p = n->parent();
+        while(p)
+        {
+            n = p;
+            p = p->parent();
+        }
+    }
+    return n;
+}
+
+inline IndexComponentBase * IndexNodeBase::unlink() noexcept
+{
+    IndexComponentBase * p = parent();
+    if(p)
+    {
+        p->children.erase(p->children.iterator_to(*this));
+        setParent(nullptr);
+    }
+    return p;
+}
+
+inline bool IndexNodeBase::isLinkedTo(IndexComponentBase const * ancestor) const noexcept
+{
+    Node const * node = this;
+    while(node)
+    {
+        node = node->parent();
+        if(node == ancestor)
+            return true;
+    }
+    return false;
+}
+
+//---------------------
+// Leaf stuff
+//--------------------
+
+inline IndexLeafBase::size_type IndexLeafBase::calculateHeight() const noexcept
+{
+    size_type n = 0;
+    IndexComponentBase const * node = parent();
+    while(node)
+    {
+        ++n;
+        node = node->parent();
+    }
+    return n;
+}
+
+//---------------------
+// Component stuff
+//--------------------
+
+inline void IndexComponentBase::link(IndexLeafBase * leaf) noexcept
+{
+    BOOST_ASSERT(!leaf->parent());
+    leaf->setParent(this);
+    children.push_back(*leaf);//insert leaves at the end
+}
+
+inline void IndexComponentBase::link(IndexComponentBase * node) noexcept
+{
+    BOOST_ASSERT(!node->parent());
+    node->setParent(this);
+    children.push_front(*node);//insert components at the beginning
+}
+
+template<typename Child>
+inline IndexComponentBase * IndexComponentBase::relink(Child * child) noexcept
+{
+    IndexComponentBase * old = child->unlink();
+    link(child);
+    return old;
+}
+
+inline void IndexComponentBase::absorb(IndexComponentBase & node) noexcept
+{
+    if(!node.empty())
+    {
+        iterator i = node.begin();
+        // go over child components
+        while((i != node.end()) && i->isComponent())
+        {
+            i->setParent(this);
+            ++i;
+        }
+        // i now points to first leaf of node
+        // insert components at the beginning of child list
+        children.splice(begin(), node.children, node.begin(), i);
+        // go over child leaves
+        while(i != node.end())
+        {
+            i->setParent(this);
+            ++i;
+        }
+        // insert leaves at the end
+        children.splice(end(), node.children);
+    }
+}
@@ -75,6 +75,16 @@ public :
      */
     typedef uint32_t size_type;
 
+    /** \brief Lists of nodes outside of the tree, e.g. roots. */
+    template<typename T, bool ConstantTimeSize>
+    using List = boost::intrusive::list<T,
+        boost::intrusive::size_type<size_type>,
+        boost::intrusive::constant_time_size<ConstantTimeSize>
+        >;
+
+    /** \brief Nodes can be allocated anywhere. */
+    static constexpr bool contiguous_storage = false;
+
     /** \brief Default constructor. parent=nullptr, tag=0 */
     NodeBase() noexcept
         : m_parent(nullptr) {}
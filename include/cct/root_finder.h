@@ -234,6 +234,8 @@ class PackedRootFinder
 {
 private :
     size_t count;
+    // allocated element count, memory is reused for smaller counts
+    size_t capacity;
     //parents[i] < count -> child
     //parents[i] >= count -> root, rank = parents[i]-count
     Index * parents;
@@ -274,11 +276,11 @@ public :
         resetRange(0, count, d);
     }
 
-    PackedRootFinder() : count(0), parents(nullptr), datas(nullptr) {}
+    PackedRootFinder() : count(0), capacity(0), parents(nullptr), datas(nullptr) {}
 
     template<typename D>
     PackedRootFinder(size_t c, D const & d)
-        : count(0), parents(nullptr), datas(nullptr)
+        : count(0), capacity(0), parents(nullptr), datas(nullptr)
     {
         init(c, d);
     }
@@ -289,6 +291,7 @@ public :
     {
         destroy();
         count = 0;
+        capacity = 0;
         parents = nullptr;
         datas   = nullptr;
         memory.reset();
@@ -297,8 +300,9 @@ public :
     template<typename D>
     void init(size_t c, D const & d)
     {
-        if(count != c)
+        if(capacity < c)
         {
+            // grow only, smaller sets reuse the memory
             kill();
             size_t const alignment = 64;//usual cache line size
             // calculate required size
@@ -315,8 +319,9 @@ public :
             datas = new(ptr + parents_size) Data[c];
             //ptr += parents_size;
             //datas = reinterpret_cast<Data *>(ptr);
-            count = c;
+            capacity = c;
         }
+        count = c;
         reset(d);
     }
 
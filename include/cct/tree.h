@@ -1,9 +1,18 @@
 #ifndef CONNECTED_COMPONENT_TREE_TREE_H_INCLUDED
 #define CONNECTED_COMPONENT_TREE_TREE_H_INCLUDED
 
+#include "arena.h"
+#include "index_node.h"
 #include "node.h"
 
 #include "utils/fp.h"
+#include "utils/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <boost/scoped_array.hpp>
 
@@ -26,19 +35,54 @@ public :
     typedef typename Node::size_type size_type;
 
     typedef size_type LeafId;
+
+    /** \brief Memory of components
+     *
+     * Nodes with 32 bit links (IndexNodeBase) must share one memory block with leaves,
+     * so components get a fixed capacity, given to init.
+     */
+    typedef typename std::conditional<Node::contiguous_storage,
+            FixedNodeArena<Component>,
+            NodeArena<Component>
+        >::type Arena;
+
+    /** \brief List of components outside of the tree, used by builders. */
+    typedef typename Node::template List<Component, false> ComponentList;
 private :
-    typedef boost::intrusive::list<
-            Component,
-            boost::intrusive::size_type<size_type>,
-            boost::intrusive::constant_time_size<true>
-        > Roots;
+    // memory of all components
+    Arena m_arena;
+
+    typedef typename Node::template List<Component, true> Roots;
 
     Roots roots;
 
     size_type component_count;
 
+    // memory of leaves, followed by components for contiguous storage
+    boost::scoped_array<char> m_memory;
+
     size_type leaf_count;
-    boost::scoped_array<Leaf> leaves;
+    Leaf * leaves;
+
+    size_type component_capacity;
+
+    static size_t leafStorageSize(size_type lc) noexcept
+    {
+        return (size_t(lc)*sizeof(Leaf) + alignof(Component) - 1)/alignof(Component)*alignof(Component);
+    }
+
+    void allocate(size_type lc, std::false_type)
+    {
+        m_memory.reset(new char[leafStorageSize(lc)]);
+    }
+
+    void allocate(size_type lc, std::true_type)
+    {
+        size_t const size = leafStorageSize(lc) + Arena::storageSize(component_capacity);
+        BOOST_ASSERT(size <= Node::max_storage_size);
+        m_memory.reset(new char[size]);
+        m_arena.init(m_memory.get() + leafStorageSize(lc), component_capacity);
+    }
 
 public :
     size_type rootCount() const
@@ -58,6 +102,15 @@ public :
         roots.erase(roots.iterator_to(*root));
     }
 
+    Arena & arena() noexcept
+    {
+        return m_arena;
+    }
+
+    /** \brief Remove components above leaves [b, e[.
+     *
+     * Memory of removed components is reused only after reset.
+     */
     void resetRange(size_type b, size_type e)
     {
         for(size_type i = b; i != e; ++i)
@@ -70,31 +123,80 @@ public :
                 {
                     remRoot(node);
                 }
-                delete node;
+                node->~Component();
                 BOOST_VERIFY(component_count-- > 0);
                 node = parent;
             }
         }
     }
 
+    /** \brief Remove all components.
+     *
+     * Components are dropped with their arena blocks, without walking the tree.
+     * O(leaf_count + root_count)
+     */
     void reset()
     {
-        resetRange(0, leaf_count);
-        BOOST_ASSERT(roots.empty());
-        BOOST_ASSERT(component_count == 0);
+        roots.clear();
+        component_count = 0;
+        // leaves are linked to dropped components, construct them again
+        for(size_type i = 0; i < leaf_count; ++i)
+        {
+            new(leaves + i) Leaf();
+        }
+        m_arena.recycle();
     }
 
     void kill()
     {
         reset();
         // free leaves
+        for(size_type i = 0; i < leaf_count; ++i)
+        {
+            leaves[i].~Leaf();
+        }
         leaf_count = 0;
-        leaves.reset();
+        leaves = nullptr;
+        m_arena.release();
+        m_memory.reset();
     }
 
-    void init(size_type lc)
+    /** \brief Default capacity of contiguous component storage.
+     *
+     * Enough for a component above every leaf and every merge (second order trees),
+     * plus a partially used arena block for each of builder_count thread builders.
+     */
+    static size_type defaultComponentCapacity(size_type lc, size_type builder_count = 64) noexcept
+    {
+        return 2*lc + builder_count*Arena::block_size;
+    }
+
+    /** \brief Make room for builder_count thread builders in contiguous storage.
+     *
+     * Empty tree is reallocated if its capacity is too small,
+     * trees with growing arena are not changed.
+     * Builders without leaves never take a block, so the count is limited by leaf count.
+     */
+    void reserveBuilders(size_type builder_count)
     {
-        if(leaf_count == lc)
+        size_type const lc = leaf_count;
+        builder_count = std::min(builder_count, lc);
+        size_type const cc = defaultComponentCapacity(lc, builder_count);
+        if(Node::contiguous_storage && (component_capacity < cc))
+        {
+            BOOST_ASSERT(component_count == 0);
+            init(lc, cc);
+        }
+    }
+
+    /** \brief Allocate leaves.
+     *
+     * component capacity is used by contiguous storage only,
+     * other trees grow their arena on demand.
+     */
+    void init(size_type lc, size_type cc)
+    {
+        if((leaf_count == lc) && (component_capacity == cc))
         {
             // avoid reallocation if new size is the same as before
             reset();
@@ -102,29 +204,42 @@ public :
         else
         {
             kill();
-            leaves.reset(new Leaf[lc]);
+            component_capacity = cc;
+            allocate(lc, std::integral_constant<bool, Node::contiguous_storage>());
+            leaves = reinterpret_cast<Leaf *>(m_memory.get());
             leaf_count = lc;
+            reset();
         }
     }
 
+    void init(size_type lc)
+    {
+        init(lc, defaultComponentCapacity(lc));
+    }
+
     Tree()
-        : component_count(0), leaf_count(0)
+        : component_count(0), leaf_count(0), leaves(nullptr), component_capacity(0)
     {}
 
     explicit Tree(size_type lc)
-        : component_count(0), leaf_count(0)
+        : component_count(0), leaf_count(0), leaves(nullptr), component_capacity(0)
     {
         init(lc);
     }
 
+    Tree(size_type lc, size_type cc)
+        : component_count(0), leaf_count(0), leaves(nullptr), component_capacity(0)
+    {
+        init(lc, cc);
+    }
+
     // Tree is noncopyable
     Tree(Tree const &) = delete;
     Tree & operator=(Tree const &) = delete;
 
     ~Tree() noexcept
     {
-        // reset is enough. Leaves will be freed automatically.
-        reset();
+        kill();
     }
 
     size_type nodeCount() const noexcept
@@ -139,6 +254,10 @@ public :
     {
         return component_count;
     }
+    size_type componentCapacity() const noexcept
+    {
+        return component_capacity;
+    }
 
     bool isLeafId(size_type i) const
     {
@@ -148,13 +267,13 @@ public :
     Leaf * leaf(size_type i)
     {
         BOOST_ASSERT(isLeafId(i));
-        return leaves.get() + i;
+        return leaves + i;
     }
 
     Leaf const * leaf(size_type i) const
     {
         BOOST_ASSERT(isLeafId(i));
-        return leaves.get() + i;
+        return leaves + i;
     }
 
     bool isNodeLeaf(Node const & node) const noexcept
@@ -171,7 +290,7 @@ public :
     size_type leafId(Leaf const & leaf) const
     {
         BOOST_ASSERT(isNodeLeaf(leaf));
-        return &leaf - leaves.get();
+        return &leaf - leaves;
     }
 /*
     template<typename ComponentCompare, typename LeafCompare>
@@ -194,6 +313,10 @@ public :
         roots.sort(c);
     }
 */
+private :
+    // traversal stack, component and its next child
+    typedef std::vector<std::pair<Component const *, typename Component::const_iterator>> Stack;
+
     template<
         typename PreComponentFunction,
         typename PostComponentFunction,
@@ -201,50 +324,135 @@ public :
     >
     void forEach(
         Component const & node,
-        PreComponentFunction pre_func,
-        PostComponentFunction post_func,
-        LeafFunction leaf_func
+        PreComponentFunction & pre_func,
+        PostComponentFunction & post_func,
+        LeafFunction & leaf_func,
+        Stack & stack
     ) const
     {
         pre_func(node);
-        auto i = node.begin();
-        while((i != node.end()) && isNodeComponent(*i))
-        {
-            forEach(static_cast<Component const &>(*i), pre_func, post_func, leaf_func);
-            ++i;
-        }
-        while(i != node.end())
+        stack.emplace_back(&node, node.begin());
+        while(!stack.empty())
         {
-            leaf_func(static_cast<Leaf const &>(*i));
-            ++i;
+            Component const & c = *stack.back().first;
+            typename Component::const_iterator & i = stack.back().second;
+            if((i != c.end()) && isNodeComponent(*i))
+            {
+                // descend, stack can be reallocated
+                Component const & child = static_cast<Component const &>(*i);
+                ++i;
+                pre_func(child);
+                stack.emplace_back(&child, child.begin());
+                continue;
+            }
+            while(i != c.end())
+            {
+                leaf_func(static_cast<Leaf const &>(*i));
+                ++i;
+            }
+            post_func(c);
+            stack.pop_back();
         }
-        post_func(node);
     }
 
+public :
+    /** \brief Depth first traversal of a subtree.
+     *
+     * pre_func(component) - before its children
+     * post_func(component) - after its children
+     * leaf_func(leaf) - leaves of a component after its child components
+     * Explicit stack, so deep trees (e.g. gradients) do not overflow the call stack.
+     * O(subtree size)
+     */
     template<
         typename PreComponentFunction,
         typename PostComponentFunction,
         typename LeafFunction
     >
     void forEach(
+        Component const & node,
         PreComponentFunction pre_func,
         PostComponentFunction post_func,
         LeafFunction leaf_func
     ) const
     {
+        Stack stack;
+        forEach(node, pre_func, post_func, leaf_func, stack);
+    }
+
+    template<
+        typename PreComponentFunction,
+        typename PostComponentFunction,
+        typename LeafFunction
+    >
+    void forEach(
+        PreComponentFunction pre_func,
+        PostComponentFunction post_func,
+        LeafFunction leaf_func
+    ) const
+    {
+        Stack stack;
         for(Component const & root : roots)
         {
-            forEach(root, pre_func, post_func, leaf_func);
+            forEach(root, pre_func, post_func, leaf_func, stack);
         }
     }
 
-    size_type countDegenerateComponents() const;
+    /** \brief Traversal of independent subtrees by several threads.
+     *
+     * Top of the tree is expanded level by level until there are enough subtrees
+     * (or nothing to expand), subtrees are then traversed concurrently by forEach.
+     * Functions are called concurrently, so they must be thread safe.
+     * Order guarantees are the same as forEach within every subtree :
+     *  pre_func(c) before and post_func(c) after all nodes below c.
+     * With threads <= 1 it is just forEach.
+     */
+    template<
+        typename PreComponentFunction,
+        typename PostComponentFunction,
+        typename LeafFunction
+    >
+    void parallelForEach(
+        PreComponentFunction pre_func,
+        PostComponentFunction post_func,
+        LeafFunction leaf_func,
+        unsigned threads
+    ) const;
+
+    size_type countDegenerateComponents(unsigned threads = 1) const;
+
+    /** \brief Splice out components with less than two children.
+     *
+     * Children are moved to the parent of a removed component,
+     * children of a removed root become roots.
+     * \returns number of removed components
+     */
+    size_type removeDegenerateComponents();
+
+    /** \brief Calls leaf_func(leaf, depth) for every leaf below a root.
+     *
+     * Depth is the number of components above the leaf.
+     * Traversal by parallelForEach, every thread follows the depth of its last component,
+     * only subtrees started by other threads count their ancestors.
+     * O(node_count + height * 8*threads)
+     */
+    template<typename LeafFunction>
+    void forEachLeafDepth(LeafFunction leaf_func, unsigned threads) const;
+
+    /** \brief Maximal number of components above a leaf.
+     *
+     * One traversal with a depth counter, see forEachLeafDepth.
+     * O(node_count)
+     */
+    size_type calculateHeight(unsigned threads = 1) const;
 
-    /**
-     * Naive and slow 
-     * O(leaf_count*tree_height)
+    /** \brief Number of components above every leaf.
+     *
+     * Unconnected leaves have depth 0.
+     * O(node_count)
+     * \returns tree height
      */
-    size_type calculateHeight() const;
+    size_type calculateLeafDepths(size_type * depths/*[leaf_count]*/, unsigned threads = 1) const;
 
     void prettyPrint(std::ostream & out, Leaf const & leaf);
     void prettyPrint(std::ostream & out, Node const & node, std::string indent, bool last);
@@ -1,29 +1,212 @@
+template<typename C, typename L>
+template<
+    typename PreComponentFunction,
+    typename PostComponentFunction,
+    typename LeafFunction
+>
+void Tree<C,L>::parallelForEach(
+    PreComponentFunction pre_func,
+    PostComponentFunction post_func,
+    LeafFunction leaf_func,
+    unsigned threads
+) const
+{
+    if(threads <= 1)
+    {
+        forEach(pre_func, post_func, leaf_func);
+        return;
+    }
+    // a few subtrees per thread to balance uneven subtree sizes
+    size_t const task_count = 8*size_t(threads);
+    // expanded components in top-down order, subtrees below them
+    std::vector<Component const *> top;
+    std::vector<Component const *> subtrees;
+    for(Component const & root : roots)
+    {
+        subtrees.push_back(&root);
+    }
+    std::vector<Component const *> next;
+    while(!subtrees.empty() && (subtrees.size() < task_count))
+    {
+        next.clear();
+        for(Component const * c : subtrees)
+        {
+            pre_func(*c);
+            top.push_back(c);
+            auto i = c->begin();
+            while((i != c->end()) && isNodeComponent(*i))
+            {
+                next.push_back(&static_cast<Component const &>(*i));
+                ++i;
+            }
+            while(i != c->end())
+            {
+                leaf_func(static_cast<Leaf const &>(*i));
+                ++i;
+            }
+        }
+        subtrees.swap(next);
+    }
+    utils::parallelFor(0, subtrees.size(), threads,
+        [&](size_t b, size_t e)
+        {
+            Stack stack;
+            for(size_t k = b; k < e; ++k)
+            {
+                forEach(*subtrees[k], pre_func, post_func, leaf_func, stack);
+            }
+        }
+    );
+    // children were expanded after their parents
+    for(auto i = top.rbegin(); i != top.rend(); ++i)
+    {
+        post_func(**i);
+    }
+}
+
 template<typename C, typename L>
 typename Tree<C,L>::size_type
-Tree<C,L>::countDegenerateComponents() const
+Tree<C,L>::countDegenerateComponents(unsigned threads) const
 {
-    size_type count = 0;
-    forEach(
+    std::atomic<size_type> count(0);
+    parallelForEach(
         [&](Component const & c)
         {
             if(c.isDegenerate())
-                ++count;
+                count.fetch_add(1, std::memory_order_relaxed);
         },
-        utils::fp::ignore(), utils::fp::ignore()
+        utils::fp::ignore(), utils::fp::ignore(),
+        threads
     );
-    return count;
+    return count.load();
 }
 
 template<typename C, typename L>
 typename Tree<C,L>::size_type
-Tree<C,L>::calculateHeight() const
+Tree<C,L>::removeDegenerateComponents()
 {
-    size_type height = 0;
-    for(size_type i = 0; i < leaf_count; ++i)
+    std::vector<Component *> degenerates;
+    forEach(
+        [&](Component const & c)
+        {
+            if(c.isDegenerate())
+                degenerates.push_back(const_cast<Component *>(&c));
+        },
+        utils::fp::ignore(), utils::fp::ignore()
+    );
+    // removal keeps all other nodes in place, so the pointers stay valid
+    for(Component * node : degenerates)
     {
-        height = std::max(height, leaf(i)->calculateHeight());
+        Component * parent = static_cast<Component*>(node->parent());
+        if(parent)
+        {
+            parent->absorb(*node);
+            node->unlink();
+        }
+        else
+        {
+            while(!node->empty())
+            {
+                Node & child = *node->begin();
+                child.unlink();
+                if(isNodeComponent(child))
+                    addRoot(static_cast<Component*>(&child));
+            }
+            remRoot(node);
+        }
+        node->~Component();
+        BOOST_VERIFY(component_count-- > 0);
     }
-    return height;
+    return degenerates.size();
+}
+
+template<typename C, typename L>
+template<typename LeafFunction>
+void Tree<C,L>::forEachLeafDepth(LeafFunction leaf_func, unsigned threads) const
+{
+    // last component entered by the thread in this call and its depth
+    struct Cursor
+    {
+        size_t call;
+        Component const * node;
+        size_type depth;
+    };
+    static std::atomic<size_t> calls(0);
+    static thread_local Cursor cursor = { 0, nullptr, 0 };
+    size_t const call = ++calls;
+
+    // components above node
+    auto depth = [&](Node const & node)
+    {
+        Component const * p = static_cast<Component const *>(node.parent());
+        if((cursor.call == call) && (cursor.node == p))
+            return cursor.depth;
+        size_type d = 0;
+        for(; p; p = static_cast<Component const *>(p->parent()))
+        {
+            ++d;
+        }
+        return d;
+    };
+    parallelForEach(
+        [&](Component const & c)
+        {
+            cursor = Cursor{ call, &c, size_type(depth(c)+1) };
+        },
+        [&](Component const & c)
+        {
+            if((cursor.call == call) && (cursor.node == &c))
+            {
+                cursor.node = static_cast<Component const *>(c.parent());
+                --cursor.depth;
+            }
+            else
+            {
+                cursor.call = 0;
+            }
+        },
+        [&](Leaf const & leaf)
+        {
+            leaf_func(leaf, depth(leaf));
+        },
+        threads
+    );
+}
+
+template<typename C, typename L>
+typename Tree<C,L>::size_type
+Tree<C,L>::calculateHeight(unsigned threads) const
+{
+    std::atomic<size_type> height(0);
+    forEachLeafDepth(
+        [&](Leaf const &, size_type depth)
+        {
+            size_type h = height.load(std::memory_order_relaxed);
+            while((h < depth) && !height.compare_exchange_weak(h, depth, std::memory_order_relaxed))
+            {}
+        },
+        threads
+    );
+    return height.load();
+}
+
+template<typename C, typename L>
+typename Tree<C,L>::size_type
+Tree<C,L>::calculateLeafDepths(size_type * depths, unsigned threads) const
+{
+    std::fill_n(depths, leaf_count, size_type(0));
+    std::atomic<size_type> height(0);
+    forEachLeafDepth(
+        [&](Leaf const & leaf, size_type depth)
+        {
+            depths[leafId(leaf)] = depth;
+            size_type h = height.load(std::memory_order_relaxed);
+            while((h < depth) && !height.compare_exchange_weak(h, depth, std::memory_order_relaxed))
+            {}
+        },
+        threads
+    );
+    return height.load();
 }
 
 // Pretty printing
@@ -0,0 +1,461 @@
+#ifndef CONNECTED_COMPONENT_TREE_VIDEO_BUILDER_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_VIDEO_BUILDER_H_INCLUDED
+
+#include "cct/image_graph.h"
+#include "cct/volume_builder.h"
+#include "cct/array_storage.h"
+#include "cct/array_tree.h"
+#include "cct/root_finder.h"
+
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include <boost/assert.hpp>
+
+#include <opencv2/core/core.hpp>
+
+namespace cct {
+
+namespace video {
+
+/** \brief Streaming alpha-tree of a frame sequence (2D+t).
+ *
+ * Graph is the volume of frames stacked along z :
+ *  4-connected pixels of every frame
+ *  + temporal edges between the same pixels of consecutive frames.
+ * Frames are added one at a time, only a window of two frames is kept :
+ *  the spatial forest of the previous frame and a union-find of both frames.
+ * Kruskal over the window drops every edge which closes a cycle there,
+ * such edge is not needed by the alpha-tree of the whole sequence.
+ * Remaining edges are merged right away into the alpha-tree of the frames so far,
+ * paths of both voxels above the edge are zipped as in ThreadBuilder::merge_paths.
+ * No edges are kept outside of the window, memory is the tree itself.
+ *
+ * Components of the tree are never moved while frames are added :
+ *  components of the same level are merged by marking one dead,
+ *  components left with a single child are spliced out the same way,
+ *  parents skip dead components and are compressed on the way.
+ * Dead components are removed when they outnumber half of the voxels.
+ *
+ * I must hold the voxel count of the whole sequence.
+ */
+template<typename T, typename I, typename S, typename Weight>
+class AlphaTreeBuilder
+{
+public :
+    typedef cct::volume::Edge<I, Weight> Edge;
+    typedef cct::volume::Size3<size_t> Size3;
+private :
+    typedef cct::image::Edge<T, Weight> ImageEdge;
+
+    cv::Size_<T> m_size;
+    cv::Size_<T> m_tile;
+    size_t m_frame_count;
+
+    // edges of the current frame, reused
+    std::vector<ImageEdge> m_edges;
+    std::vector<ImageEdge> m_connectors;
+
+    // spatial forest of the last frame, not in the tree yet
+    std::vector<Edge> m_last;
+    std::vector<Edge> m_next;
+
+    // union-find of the previous and the current frame
+    cct::PackedRootFinder<I, I> m_root;
+
+    // alpha-tree of the sequence, parents are component indices or none()
+    std::vector<I> m_leaf_parents;//[voxels]
+    std::vector<I> m_comp_parents;
+    std::vector<Weight> m_comp_levels;
+    // child count, none() for dead components
+    std::vector<I> m_comp_children;
+    I m_dead_count;
+    // components which lost a child during the last merge
+    std::vector<I> m_lost;
+
+    static I none() noexcept
+    {
+        return std::numeric_limits<I>::max();
+    }
+
+    I pixelCount() const
+    {
+        return I(m_size.width)*I(m_size.height);
+    }
+
+    bool dead(I c) const
+    {
+        return m_comp_children[c] == none();
+    }
+
+    /** \brief Live component of a parent link, the path is compressed. */
+    I live(I & parent)
+    {
+        I p = parent;
+        while((p != none()) && dead(p))
+        {
+            p = m_comp_parents[p];
+        }
+        // dead components on the path lead to p as well
+        for(I q = parent; q != p;)
+        {
+            I const next = m_comp_parents[q];
+            m_comp_parents[q] = p;
+            q = next;
+        }
+        parent = p;
+        return p;
+    }
+
+    /** \brief Relink to component p (or none()), child counts follow. */
+    void link(I & parent, I p)
+    {
+        I const old = live(parent);
+        if(old == p)
+            return;
+        if(old != none())
+        {
+            --m_comp_children[old];
+            m_lost.push_back(old);
+        }
+        if(p != none())
+            ++m_comp_children[p];
+        parent = p;
+    }
+
+    /** \brief Merge component c into component n of the same level. */
+    void absorb(I c, I n)
+    {
+        BOOST_ASSERT(!dead(c) && !dead(n));
+        BOOST_ASSERT(!(m_comp_levels[c] < m_comp_levels[n]) && !(m_comp_levels[n] < m_comp_levels[c]));
+        link(m_comp_parents[c], none());
+        m_comp_children[n] += m_comp_children[c];
+        m_comp_children[c] = none();
+        m_comp_parents[c] = n;
+        ++m_dead_count;
+    }
+
+    /** \brief Add edge of voxels a, b to the tree.
+     *
+     * Components above the edge on both paths are zipped by level,
+     * the ones of the same level are merged.
+     * O(levels below and above the edge)
+     */
+    /** \brief Highest component of voxel v below w (none for the leaf itself) and its parent. */
+    void climb(I v, Weight w, I & x, I & p)
+    {
+        x = none();
+        p = live(m_leaf_parents[v]);
+        while((p != none()) && (m_comp_levels[p] < w))
+        {
+            x = p;
+            p = live(m_comp_parents[p]);
+        }
+    }
+
+    void merge(I a, I b, Weight w)
+    {
+        I xa, pa, xb, pb;
+        climb(a, w, xa, pa);
+        climb(b, w, xb, pb);
+        // connected below w
+        if((xa != none()) && (xa == xb))
+            return;
+
+        // component at level w
+        I n;
+        if((pa != none()) && !(w < m_comp_levels[pa]))
+        {
+            n = pa;
+        }
+        else if((pb != none()) && !(w < m_comp_levels[pb]))
+        {
+            n = pb;
+        }
+        else
+        {
+            n = I(m_comp_parents.size());
+            m_comp_parents.push_back(none());
+            m_comp_levels.push_back(w);
+            m_comp_children.push_back(0);
+        }
+        // rest of both paths above n
+        I u = (pa == n) ? live(m_comp_parents[n]) : pa;
+        I v = (pb == n) ? live(m_comp_parents[n]) : pb;
+        if((v != none()) && (v == pb) && !(w < m_comp_levels[v]))
+        {
+            // pa and pb are both at level w
+            I const next = live(m_comp_parents[v]);
+            absorb(v, n);
+            v = next;
+        }
+        link((xa == none()) ? m_leaf_parents[a] : m_comp_parents[xa], n);
+        link((xb == none()) ? m_leaf_parents[b] : m_comp_parents[xb], n);
+
+        // zip, cur is the highest component already on the merged path
+        I cur = n;
+        for(;;)
+        {
+            if(u == v)
+                break;
+            // u is the lower one
+            if((u == none()) || ((v != none()) && (m_comp_levels[v] < m_comp_levels[u])))
+                std::swap(u, v);
+            if(v == none())
+                break;
+            if(!(m_comp_levels[u] < m_comp_levels[v]))
+            {
+                I const next = live(m_comp_parents[v]);
+                absorb(v, u);
+                v = next;
+            }
+            link(m_comp_parents[cur], u);
+            cur = u;
+            u = live(m_comp_parents[u]);
+        }
+        link(m_comp_parents[cur], u);
+
+        // splice out components with a single child
+        for(I c : m_lost)
+        {
+            BOOST_ASSERT(dead(c) || (m_comp_children[c] > 0));
+            if(m_comp_children[c] == 1)
+            {
+                m_comp_children[c] = none();
+                ++m_dead_count;
+            }
+        }
+        m_lost.clear();
+    }
+
+    /** \brief Remove dead components, indices of the live ones keep their order. */
+    void compress()
+    {
+        for(I & p : m_leaf_parents)
+        {
+            live(p);
+        }
+        I const count = I(m_comp_parents.size());
+        for(I c = 0; c < count; ++c)
+        {
+            if(!dead(c))
+                live(m_comp_parents[c]);
+        }
+        // new indices of live components
+        std::vector<I> lut(count);
+        I live_count = 0;
+        for(I c = 0; c < count; ++c)
+        {
+            if(!dead(c))
+            {
+                lut[c] = live_count;
+                m_comp_parents[live_count] = m_comp_parents[c];
+                m_comp_levels[live_count] = m_comp_levels[c];
+                m_comp_children[live_count] = m_comp_children[c];
+                ++live_count;
+            }
+        }
+        m_comp_parents.resize(live_count);
+        m_comp_levels.resize(live_count);
+        m_comp_children.resize(live_count);
+        m_dead_count = 0;
+        for(I & p : m_leaf_parents)
+        {
+            if(p != none())
+                p = lut[p];
+        }
+        for(I & p : m_comp_parents)
+        {
+            if(p != none())
+                p = lut[p];
+        }
+    }
+public :
+    AlphaTreeBuilder(cv::Size_<T> const & size, cv::Size_<T> const & tile)
+        : m_size(size), m_tile(tile), m_frame_count(0), m_dead_count(0)
+    {
+        size_t const w = size.width;
+        size_t const h = size.height;
+        m_edges.resize((w > 0) && (h > 0) ? (w-1)*h + w*(h-1) : 0);
+        m_connectors.resize(w*h);
+        m_root.init(2*pixelCount(), I(0));
+    }
+
+    size_t frameCount() const
+    {
+        return m_frame_count;
+    }
+
+    /** \brief Volume size of the frames added so far */
+    Size3 size() const
+    {
+        return Size3(m_size.width, m_size.height, m_frame_count);
+    }
+
+    /** \brief Components of the tree so far, including dead ones. */
+    size_t componentCount() const
+    {
+        return m_comp_parents.size();
+    }
+
+    /** \brief Add next frame of the sequence.
+     *
+     * e - weight of pixels of the new frame
+     * t - weight of the same pixel in the previous and the new frame,
+     *     not called for the first frame
+     */
+    template<typename EdgeWeightFunction, typename TemporalWeightFunction>
+    void addFrame(
+        EdgeWeightFunction e,//e(cv::Point, cv::Point)
+        TemporalWeightFunction t//t(cv::Point)
+    )
+    {
+        typedef cv::Point_<T> Point;
+
+        cv::Rect_<T> const rect(0, 0, m_size.width, m_size.height);
+        I const n = pixelCount();
+        // first voxel of the previous frame, local ids of the union-find are relative to it
+        I const base = (m_frame_count == 0) ? I(0) : I(m_frame_count-1)*n;
+        I const offset = I(m_frame_count)*n;
+
+        size_t const edge_count = m_edges.empty() ? 0 :
+            cct::image::getSortedImageEdges(rect, m_tile, m_edges.data(), e);
+        size_t const connector_count = (m_frame_count == 0) ? 0 :
+            cct::image::getSortedTemporalConnectors(rect, m_connectors.data(), t);
+
+        m_root.reset(I(0));
+        m_next.clear();
+        m_next.reserve(n);
+        // voxels of the new frame are single leaves
+        m_leaf_parents.resize(offset+n, none());
+
+        auto window_merge = [&](I a, I b) -> bool
+            {
+                I const ha = m_root.find_update(a-base);
+                I const hb = m_root.find_update(b-base);
+                if(ha == hb)
+                    return false;
+                m_root.merge_set(ha, hb, I(0));
+                return true;
+            };
+
+        Size3 const volume(m_size.width, m_size.height, m_frame_count+1);
+        // Kruskal over merged sorted lists : previous forest, frame edges, temporal edges
+        size_t i = 0;
+        size_t j = 0;
+        size_t k = 0;
+        while((i < m_last.size()) || (j < edge_count) || (k < connector_count))
+        {
+            if((i < m_last.size())
+                && ((j == edge_count) || !(m_edges[j].weight < m_last[i].weight))
+                && ((k == connector_count) || !(m_connectors[k].weight < m_last[i].weight)))
+            {
+                Edge const & edge = m_last[i++];
+                I const b = edge.neighbour(volume);
+                if(window_merge(edge.voxel, b))
+                    merge(edge.voxel, b, edge.weight);
+            }
+            else if((j < edge_count)
+                && ((k == connector_count) || !(m_connectors[k].weight < m_edges[j].weight)))
+            {
+                ImageEdge const & image_edge = m_edges[j++];
+                Point const & a = image_edge.points[0];
+                Point const & b = image_edge.points[1];
+                Edge edge;
+                edge.voxel = offset + I(std::min(a.x, b.x)) + I(std::min(a.y, b.y))*I(m_size.width);
+                edge.axis = (a.y == b.y) ? 0 : 1;
+                edge.weight = image_edge.weight;
+                if(window_merge(edge.voxel, edge.neighbour(volume)))
+                    m_next.push_back(edge);
+            }
+            else
+            {
+                ImageEdge const & connector = m_connectors[k++];
+                I const a = base + I(connector.points[0].x) + I(connector.points[0].y)*I(m_size.width);
+                if(window_merge(a, a+n))
+                    merge(a, a+n, connector.weight);
+            }
+        }
+        m_last.swap(m_next);
+        ++m_frame_count;
+
+        // compression passes all voxels, so it waits for as many dead components
+        if(2*size_t(m_dead_count) > m_leaf_parents.size())
+            compress();
+    }
+
+    /** \brief Build alpha-tree of all added frames.
+     *
+     * tree.leaf_count must be the voxel count of size().
+     * Builder is empty afterwards and can take a new sequence.
+     */
+    void finish(array_tree<I, S, Weight> & tree)
+    {
+        BOOST_ASSERT(cct::volume::vertexCount<I>(size()) == tree.leaf_count);
+        fill(tree);
+    }
+
+    /** \brief Build alpha-tree of all added frames into reusable storage. */
+    array_tree<I, S, Weight> & finish(array_tree_storage<I, S, Weight> & storage)
+    {
+        array_tree<I, S, Weight> & tree = storage.init(cct::volume::vertexCount<S>(size()));
+        fill(tree);
+        return tree;
+    }
+private :
+    void fill(array_tree<I, S, Weight> & tree)
+    {
+        // spatial forest of the last frame
+        Size3 const volume = size();
+        for(Edge const & edge : m_last)
+        {
+            merge(edge.voxel, edge.neighbour(volume), edge.weight);
+        }
+        compress();
+
+        // components by level, so parents[i]+lc > i
+        I const comp_count = I(m_comp_parents.size());
+        BOOST_ASSERT(tree.leaf_count + comp_count <= tree.node_capacity);
+        std::vector<I> order(comp_count);
+        std::iota(order.begin(), order.end(), I(0));
+        std::stable_sort(order.begin(), order.end(),
+            [this](I a, I b) { return m_comp_levels[a] < m_comp_levels[b]; }
+        );
+        // child counts are not needed anymore, they hold new indices
+        std::vector<I> & lut = m_comp_children;
+        for(I c = 0; c < comp_count; ++c)
+        {
+            lut[order[c]] = c;
+        }
+        I const root = tree.node_capacity - tree.leaf_count;
+        auto parent = [&](I p) -> I { return (p == none()) ? root : lut[p]; };
+        tree.node_count = tree.leaf_count + comp_count;
+        for(S l = 0; l < tree.leaf_count; ++l)
+        {
+            tree.parents[l] = parent(m_leaf_parents[l]);
+        }
+        for(I c = 0; c < comp_count; ++c)
+        {
+            tree.parents[tree.leaf_count + lut[c]] = parent(m_comp_parents[c]);
+            tree.comp_levels[lut[c]] = m_comp_levels[c];
+        }
+
+        m_frame_count = 0;
+        m_last.clear();
+        m_leaf_parents.clear();
+        m_comp_parents.clear();
+        m_comp_levels.clear();
+        m_comp_children.clear();
+        m_dead_count = 0;
+    }
+};
+
+}//namespace video
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_VIDEO_BUILDER_H_INCLUDED
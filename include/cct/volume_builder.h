@@ -0,0 +1,298 @@
+#ifndef CONNECTED_COMPONENT_TREE_VOLUME_BUILDER_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_VOLUME_BUILDER_H_INCLUDED
+
+#include "cct/volume_graph.h"
+#include "cct/array_storage.h"
+#include "cct/array_tree.h"
+#include "cct/root_finder.h"
+
+#include "utils/thread_pool.h"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace cct {
+
+namespace volume {
+
+/** \brief Kruskal-like alpha-tree construction from sorted volume edges.
+ *
+ * root must contain leaf_count singletons with data = leaf index.
+ */
+template<
+    typename T, typename I, typename S, typename Weight
+>
+void buildAlphaTree(
+    Size3<T> const & size,
+    Edge<I, Weight> const * edges, size_t edge_count,
+    array_tree<I, S, Weight> & tree,
+    cct::PackedRootFinder<S, I> & root,
+    I * merges//[max(leaf_count, node_capacity-leaf_count+1)]
+)
+{
+    if(edge_count == 0)
+        return;
+
+    Weight weight = edges[0].weight;
+    S layer_begin = tree.node_count;
+    for(size_t i = 0; i < edge_count; ++i)
+    {
+        if(edges[i].weight > weight)
+        {
+            weight = edges[i].weight;
+            layer_begin = tree.node_count;
+        }
+        I const ha = root.find_update(edges[i].voxel);
+        I const hb = root.find_update(edges[i].neighbour(size));
+        if(ha != hb)
+        {
+            root.merge_set(ha, hb,
+                tree.alpha_merge(root.data(ha), root.data(hb), layer_begin, edges[i].weight, merges)
+            );
+        }
+    }
+    tree.finish_alpha_merges(merges);
+    tree.compress(merges);
+}
+
+/** \brief Alpha-tree of 6-connected volume.
+ *
+ * I must hold the voxel count, e.g. 1024^3 volumes need 64 bit indices.
+ */
+template<
+    typename T, typename V, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction
+>
+void buildAlphaTree(
+    View<V> const & view, Size3<T> const & tile,
+    array_tree<I, S, Weight> & tree,
+    EdgeWeightFunction e//f(V, V)
+)
+{
+    typedef Edge<I, Weight> Edge;
+
+    Size3<T> const size(view.size);
+    BOOST_ASSERT(vertexCount<I>(size) == tree.leaf_count);
+
+    std::vector<Edge> edges(edgeCount<size_t>(size));
+    size_t const edge_count = getSortedVolumeEdges(
+        view, Box<T>(0, 0, 0, size.width, size.height, size.depth), tile, edges.data(), e);
+
+    cct::PackedRootFinder<S, I> root(vertexCount<I>(size), cct::LeafIndexTag());
+
+    std::unique_ptr<I[]> merges(new I[std::max<size_t>(tree.leaf_count, tree.node_capacity-tree.leaf_count+1)]);
+
+    buildAlphaTree(size, edges.data(), edge_count, tree, root, merges.get());
+}
+
+/** \brief Build volume alpha-tree into reusable storage. */
+template<
+    typename T, typename V, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction
+>
+array_tree<I, S, Weight> & buildAlphaTree(
+    View<V> const & view, Size3<T> const & tile,
+    array_tree_storage<I, S, Weight> & storage,
+    EdgeWeightFunction e//f(V, V)
+)
+{
+    typedef Edge<I, Weight> Edge;
+
+    Size3<T> const size(view.size);
+    S const leaf_count = vertexCount<S>(size);
+    array_tree<I, S, Weight> & tree = storage.init(leaf_count);
+
+    Edge * edges = storage.template buffer<Edge>(edgeCount<size_t>(size));
+    size_t const edge_count = getSortedVolumeEdges(
+        view, Box<T>(0, 0, 0, size.width, size.height, size.depth), tile, edges, e);
+
+    storage.root_finder().init(leaf_count, cct::LeafIndexTag());
+
+    buildAlphaTree(size, edges, edge_count, tree, storage.root_finder(), storage.merges());
+    return tree;
+}
+
+/** \brief Minimum spanning forest edges of the box, sorted by weight.
+ *
+ * Box is split along its longest axis, halves are processed in parallel
+ * and their forests are joined by the sorted edges crossing the split plane.
+ * Alpha-tree of the forest is the alpha-tree of the box.
+ *
+ * root is shared by all threads, each one touches only voxels of its box.
+ */
+template<
+    typename T, typename V, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction
+>
+void getSpanningEdges(
+    View<V> const & view, Size3<T> const & tile,
+    EdgeWeightFunction e,
+    unsigned depth,
+    Box<T> const & box,
+    cct::PackedRootFinder<S, I> & root,
+    std::vector<Edge<I, Weight>> & forest
+)
+{
+    typedef Edge<I, Weight> Edge;
+
+    Size3<T> const size(view.size);
+
+    std::vector<Edge> edges;
+    if(depth == 0)
+    {
+        edges.resize(edgeCount<size_t>(box.size()));
+        edges.resize(getSortedVolumeEdges(view, box, tile, edges.data(), e));
+    }
+    else
+    {
+        // split along the longest axis
+        uint8_t axis = 0;
+        T length = box.width;
+        if(box.height > length)
+        {
+            axis = 1;
+            length = box.height;
+        }
+        if(box.depth > length)
+        {
+            axis = 2;
+            length = box.depth;
+        }
+        T const half = length/2;
+        if(half == 0)
+        {
+            // box is a single voxel
+            forest.clear();
+            return;
+        }
+        Box<T> ba = box;
+        Box<T> bb = box;
+        // last voxels of ba along the axis
+        Box<T> plane = box;
+        switch(axis)
+        {
+        case 0 :
+            ba.width = half;
+            bb.x += half;
+            bb.width -= half;
+            plane.x += half-1;
+            plane.width = 1;
+            break;
+        case 1 :
+            ba.height = half;
+            bb.y += half;
+            bb.height -= half;
+            plane.y += half-1;
+            plane.height = 1;
+            break;
+        default :
+            ba.depth = half;
+            bb.z += half;
+            bb.depth -= half;
+            plane.z += half-1;
+            plane.depth = 1;
+            break;
+        }
+        // build partial forests
+        std::vector<Edge> fa;
+        std::vector<Edge> fb;
+        utils::TaskGroup task;
+        task.run([&]()
+        {
+            getSpanningEdges(view, tile, e, depth-1, bb, root, fb);
+        });
+        getSpanningEdges(view, tile, e, depth-1, ba, root, fa);
+        // extract connecting edges
+        std::vector<Edge> connectors;
+        connectors.reserve(vertexCount<size_t>(plane.size()));
+        for(T z = plane.z; z < plane.z+plane.depth; ++z)
+        {
+            for(T y = plane.y; y < plane.y+plane.height; ++y)
+            {
+                for(T x = plane.x; x < plane.x+plane.width; ++x)
+                {
+                    Edge edge;
+                    edge.voxel = voxelId<I>(x, y, z, size);
+                    edge.axis = axis;
+                    edge.weight = e(view(x, y, z), view(x+(axis == 0), y+(axis == 1), z+(axis == 2)));
+                    connectors.push_back(edge);
+                }
+            }
+        }
+        std::sort(connectors.begin(), connectors.end());
+        task.wait();
+        // merge sorted lists
+        std::vector<Edge> ab;
+        ab.reserve(fa.size() + fb.size());
+        std::merge(fa.begin(), fa.end(), fb.begin(), fb.end(), std::back_inserter(ab));
+        std::vector<Edge>().swap(fa);
+        std::vector<Edge>().swap(fb);
+        edges.reserve(ab.size() + connectors.size());
+        std::merge(ab.begin(), ab.end(), connectors.begin(), connectors.end(), std::back_inserter(edges));
+        // forests of halves are merged in root, start from singletons again
+        for(T z = box.z; z < box.z+box.depth; ++z)
+        {
+            for(T y = box.y; y < box.y+box.height; ++y)
+            {
+                I const id = voxelId<I>(box.x, y, z, size);
+                root.resetRange(id, id+box.width, S(0));
+            }
+        }
+    }
+    // Kruskal, keep only merging edges
+    size_t const max_count = vertexCount<size_t>(box.size())-1;
+    forest.clear();
+    forest.reserve(max_count);
+    for(Edge const & edge : edges)
+    {
+        I const ha = root.find_update(edge.voxel);
+        I const hb = root.find_update(edge.neighbour(size));
+        if(ha != hb)
+        {
+            root.merge_set(ha, hb, root.data(ha));
+            forest.push_back(edge);
+            if(forest.size() == max_count)
+                break;
+        }
+    }
+}
+
+/** \brief Parallel alpha-tree of 6-connected volume.
+ *
+ * 2^depth boxes are processed in parallel, see getSpanningEdges.
+ */
+template<
+    typename T, typename V, typename I, typename S, typename Weight,
+    typename EdgeWeightFunction
+>
+void buildAlphaTree(
+    View<V> const & view, Size3<T> const & tile,
+    array_tree<I, S, Weight> & tree,
+    EdgeWeightFunction e,//f(V, V)
+    unsigned depth
+)
+{
+    typedef Edge<I, Weight> Edge;
+
+    Size3<T> const size(view.size);
+    BOOST_ASSERT(vertexCount<I>(size) == tree.leaf_count);
+
+    cct::PackedRootFinder<S, I> root(vertexCount<I>(size), S(0));
+    std::vector<Edge> forest;
+    getSpanningEdges(view, tile, e, depth,
+        Box<T>(0, 0, 0, size.width, size.height, size.depth), root, forest);
+
+    root.reset(cct::LeafIndexTag());
+
+    std::unique_ptr<I[]> merges(new I[std::max<size_t>(tree.leaf_count, tree.node_capacity-tree.leaf_count+1)]);
+
+    buildAlphaTree(size, forest.data(), forest.size(), tree, root, merges.get());
+}
+
+}//namespace volume
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_VOLUME_BUILDER_H_INCLUDED
@@ -0,0 +1,286 @@
+#ifndef CONNECTED_COMPONENT_TREE_VOLUME_GRAPH_H_INCLUDED
+#define CONNECTED_COMPONENT_TREE_VOLUME_GRAPH_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <numeric>
+
+#include <boost/assert.hpp>
+
+namespace cct {
+
+namespace volume {
+
+/** \brief Size of a volume */
+template<typename T>
+struct Size3
+{
+    T width;
+    T height;
+    T depth;
+
+    Size3() : width(0), height(0), depth(0) {}
+
+    Size3(T w, T h, T d) : width(w), height(h), depth(d) {}
+
+    template<typename U>
+    Size3(Size3<U> const & s) : width(s.width), height(s.height), depth(s.depth) {}
+};
+
+/** \brief Axis aligned sub-volume */
+template<typename T>
+struct Box
+{
+    T x, y, z;
+    T width, height, depth;
+
+    Box() : x(0), y(0), z(0), width(0), height(0), depth(0) {}
+
+    Box(T x_, T y_, T z_, T w, T h, T d)
+        : x(x_), y(y_), z(z_), width(w), height(h), depth(d)
+    {}
+
+    Size3<T> size() const
+    {
+        return Size3<T>(width, height, depth);
+    }
+};
+
+/** \brief Read only view of a strided 3D buffer.
+ *
+ * Steps are in elements, so rows and slices may be padded.
+ */
+template<typename V>
+struct View
+{
+    V const * data;
+    Size3<size_t> size;
+    size_t row_step;
+    size_t slice_step;
+
+    View(V const * d, Size3<size_t> const & s)
+        : data(d), size(s), row_step(s.width), slice_step(s.width*s.height)
+    {}
+
+    View(V const * d, Size3<size_t> const & s, size_t rs, size_t ss)
+        : data(d), size(s), row_step(rs), slice_step(ss)
+    {
+        BOOST_ASSERT(row_step >= size.width);
+        BOOST_ASSERT(slice_step >= row_step*size.height);
+    }
+
+    V const & operator()(size_t x, size_t y, size_t z) const
+    {
+        return data[z*slice_step + y*row_step + x];
+    }
+};
+
+// 1D indices for voxels, I must hold width*height*depth
+
+template<typename I, typename T>
+inline I voxelId(T x, T y, T z, Size3<T> const & s)
+{
+    BOOST_ASSERT(x < s.width);
+    BOOST_ASSERT(y < s.height);
+    BOOST_ASSERT(z < s.depth);
+    return I(x) + I(s.width)*(I(y) + I(s.height)*I(z));
+}
+
+// Volume graph properties, 6-connectivity
+
+template<typename I, typename T>
+inline I vertexCount(Size3<T> const & size)
+{
+    return I(size.width)*I(size.height)*I(size.depth);
+}
+
+template<typename I, typename T>
+inline I edgeCount(Size3<T> const & size)
+{
+    if((size.width == T(0)) || (size.height == T(0)) || (size.depth == T(0)))
+        return 0;
+    I const w = size.width;
+    I const h = size.height;
+    I const d = size.depth;
+    return (w-1)*h*d + w*(h-1)*d + w*h*(d-1);
+}
+
+/** \brief Weighted edge of volume graph
+ *
+ * Connects voxel and its next neighbour along axis (0 - x, 1 - y, 2 - z).
+ * Only the voxel index is stored to keep edges small for big volumes.
+ */
+template<typename I, typename W>
+struct Edge
+{
+    typedef I Index;
+    typedef W Weight;
+
+    I voxel;
+
+    uint8_t axis;
+
+    Weight weight;
+
+    /** \brief Index of the other voxel */
+    template<typename T>
+    I neighbour(Size3<T> const & size) const
+    {
+        return voxel + ((axis == 0) ? I(1) : (axis == 1) ? I(size.width) : I(size.width)*I(size.height));
+    }
+
+    bool operator<(Edge const & e) const
+    {
+        return weight < e.weight;
+    }
+};
+
+// Volume graph iteration
+
+/** \brief Call function for every volume edge.
+ *
+ * Calls f for every 6-connected edge of the box, box is scanned by tiles.
+ * Edges leaving the box are skipped.
+ */
+template<typename I, typename T, typename F>
+F forEachEdge(
+    Size3<T> const & size,// whole volume, for voxel indices
+    Box<T> const & box,
+    Size3<T> const & tile,
+    F f// f(voxel id, axis, x, y, z)
+)
+{
+    BOOST_ASSERT(tile.width > 0);
+    BOOST_ASSERT(tile.height > 0);
+    BOOST_ASSERT(tile.depth > 0);
+    T const xe = box.x+box.width;
+    T const ye = box.y+box.height;
+    T const ze = box.z+box.depth;
+    for(T tz = box.z; tz < ze; tz += std::min<T>(tile.depth, ze-tz))
+    {
+        T const tze = tz + std::min<T>(tile.depth, ze-tz);
+        for(T ty = box.y; ty < ye; ty += std::min<T>(tile.height, ye-ty))
+        {
+            T const tye = ty + std::min<T>(tile.height, ye-ty);
+            for(T tx = box.x; tx < xe; tx += std::min<T>(tile.width, xe-tx))
+            {
+                T const txe = tx + std::min<T>(tile.width, xe-tx);
+                for(T z = tz; z < tze; ++z)
+                {
+                    for(T y = ty; y < tye; ++y)
+                    {
+                        I id = voxelId<I>(tx, y, z, size);
+                        for(T x = tx; x < txe; ++x, ++id)
+                        {
+                            if(x+1 < xe)
+                                f(id, 0, x, y, z);
+                            if(y+1 < ye)
+                                f(id, 1, x, y, z);
+                            if(z+1 < ze)
+                                f(id, 2, x, y, z);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return f;
+}
+
+// Extraction of graph edges
+
+/** \brief Extracts volume edges of the box
+ *
+ * e is called for values of both voxels.
+ */
+template<typename I, typename W, typename T, typename V, typename EdgeWeightFunction>
+size_t getVolumeEdges(
+    View<V> const & view,
+    Box<T> const & box, Size3<T> const & tile,
+    Edge<I, W> * edges,//[edgeCount(box.size())]
+    EdgeWeightFunction e//f(V, V)
+)
+{
+    Size3<T> const size(view.size);
+    size_t count = 0;
+    forEachEdge<I>(size, box, tile,
+        [&](I id, uint8_t axis, T x, T y, T z)
+        {
+            Edge<I, W> & edge = edges[count++];
+            edge.voxel = id;
+            edge.axis = axis;
+            edge.weight = e(view(x, y, z), view(x+(axis == 0), y+(axis == 1), z+(axis == 2)));
+        }
+    );
+    return count;
+}
+
+/** \brief Extracts volume edges of the box and sorts them
+ *
+ * Depending on edge weight :
+ *  uint8_t - O(|E|)
+ *   countingsort + 2 volume passes
+ *  otherwise - O(|E|log|E|)
+ *   std::sort + 1 volume pass
+ */
+template<typename I, typename W, typename T, typename V, typename EdgeWeightFunction>
+size_t getSortedVolumeEdges(
+    View<V> const & view,
+    Box<T> const & box, Size3<T> const & tile,
+    Edge<I, W> * edges,//[edgeCount(box.size())]
+    EdgeWeightFunction e//f(V, V)
+)
+{
+    size_t const count = getVolumeEdges(view, box, tile, edges, e);
+    std::sort(edges, edges + count);
+    return count;
+}
+
+template<typename I, typename T, typename V, typename EdgeWeightFunction>
+size_t getSortedVolumeEdges(
+    View<V> const & view,
+    Box<T> const & box, Size3<T> const & tile,
+    Edge<I, uint8_t> * edges,//[edgeCount(box.size())]
+    EdgeWeightFunction e//f(V, V)
+)
+{
+    Size3<T> const size(view.size);
+    auto weight = [&](uint8_t axis, T x, T y, T z) -> uint8_t
+        {
+            return e(view(x, y, z), view(x+(axis == 0), y+(axis == 1), z+(axis == 2)));
+        };
+    // build histogram, edge count of big volumes does not fit 32 bits
+    size_t histogram[256];
+    std::fill_n(histogram, 256, 0);
+    forEachEdge<I>(size, box, tile,
+        [&](I, uint8_t axis, T x, T y, T z)
+        {
+            ++histogram[weight(axis, x, y, z)];
+        }
+    );
+    // get indices by prefix sum
+    size_t indices[257];
+    indices[0] = 0;
+    std::partial_sum(histogram, histogram + 256, indices + 1);
+    // extract edges
+    forEachEdge<I>(size, box, tile,
+        [&](I id, uint8_t axis, T x, T y, T z)
+        {
+            uint8_t const w = weight(axis, x, y, z);
+            Edge<I, uint8_t> & edge = edges[indices[w]++];
+            edge.voxel = id;
+            edge.axis = axis;
+            edge.weight = w;
+        }
+    );
+    BOOST_ASSERT(indices[255] == indices[256]);
+    return indices[256];
+}
+
+}//namespace volume
+
+}//namespace cct
+
+#endif//CONNECTED_COMPONENT_TREE_VOLUME_GRAPH_H_INCLUDED
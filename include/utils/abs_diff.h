@@ -97,6 +97,25 @@ public :
     }
 };
 
+/** \brief Difference of the same pixel in two frames. */
+template<typename O, typename T, int N>
+class TemporalMaxAbsDiff
+{
+    typedef cv::Vec<T,N> Vec;
+
+    cv::Mat const & m_previous;
+    cv::Mat const & m_current;
+public :
+    typedef O result_type;
+
+    TemporalMaxAbsDiff(cv::Mat const & p, cv::Mat const & c) : m_previous(p), m_current(c) {}
+
+    result_type operator()(cv::Point const & a) const
+    {
+        return max_abs_diff(m_previous.at<Vec>(a), m_current.at<Vec>(a));
+    }
+};
+
 /*
 template<typename O, typename I, typename C>
 class TODO
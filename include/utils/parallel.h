@@ -0,0 +1,45 @@
+#ifndef PARALLEL_UTILS_H_INCLUDED
+#define PARALLEL_UTILS_H_INCLUDED
+
+#include <cstddef>
+
+#include <algorithm>
+
+#include "utils/thread_pool.h"
+
+namespace utils {
+
+/** \brief Split range into contiguous chunks and process them concurrently.
+ *
+ * Calls f(b, e) for every chunk [b, e[, the calling thread processes the first one,
+ * the rest are tasks of the pool.
+ * With threads <= 1 it is just f(begin, end).
+ */
+template<typename Function>
+void parallelFor(
+    size_t begin, size_t end,
+    unsigned threads,
+    Function f, // f(size_t, size_t)
+    ThreadPool & pool = ThreadPool::global()
+)
+{
+    size_t const count = end-begin;
+    if((threads <= 1) || (count < threads))
+    {
+        f(begin, end);
+        return;
+    }
+    size_t const chunk = (count+threads-1)/threads;
+    TaskGroup group(pool);
+    for(size_t b = begin+chunk; b < end; b += chunk)
+    {
+        size_t const e = std::min(b+chunk, end);
+        group.run([&f, b, e]() { f(b, e); });
+    }
+    f(begin, begin+chunk);
+    group.wait();
+}
+
+}//namespace utils
+
+#endif//PARALLEL_UTILS_H_INCLUDED
@@ -0,0 +1,269 @@
+#ifndef THREAD_POOL_H_INCLUDED
+#define THREAD_POOL_H_INCLUDED
+
+#include <cstddef>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <boost/assert.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace utils {
+
+/** \brief Persistent worker threads with work stealing.
+ *
+ * Every worker has its own task deque, it runs its newest tasks first (LIFO)
+ * and steals the oldest tasks of others (FIFO), so big fork-join subproblems get stolen.
+ * Threads outside of the pool share one extra deque.
+ * Tasks are meant to be coarse (tiles, subtrees), deques are guarded by mutexes.
+ *
+ * Use TaskGroup for fork-join, the waiting thread runs tasks meanwhile.
+ */
+class ThreadPool
+{
+public :
+    typedef std::function<void()> Task;
+private :
+    struct Queue
+    {
+        boost::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    // [worker_count] for workers, [worker_count] for other threads
+    std::vector<std::unique_ptr<Queue>> m_queues;
+
+    boost::thread_group m_threads;
+
+    // queued tasks, workers sleep when there are none
+    std::atomic<size_t> m_pending;
+    std::atomic<bool> m_stop;
+
+    boost::mutex m_sleep_mutex;
+    boost::condition_variable m_wake;
+
+    struct Worker
+    {
+        ThreadPool const * pool;
+        size_t index;
+    };
+
+    static Worker & current() noexcept
+    {
+        static thread_local Worker worker = { nullptr, 0 };
+        return worker;
+    }
+
+    // own deque of the calling thread
+    size_t queueIndex() const noexcept
+    {
+        Worker const & w = current();
+        return (w.pool == this) ? w.index : workerCount();
+    }
+
+    bool pop(size_t i, Task & task, bool newest)
+    {
+        Queue & q = *m_queues[i];
+        boost::mutex::scoped_lock lock(q.mutex);
+        if(q.tasks.empty())
+            return false;
+        if(newest)
+        {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        --m_pending;
+        return true;
+    }
+
+    bool tryRun(size_t index)
+    {
+        Task task;
+        bool found = pop(index, task, true);
+        for(size_t k = 1; !found && (k < m_queues.size()); ++k)
+        {
+            found = pop((index+k) % m_queues.size(), task, false);
+        }
+        if(found)
+            task();
+        return found;
+    }
+
+    void work(size_t index)
+    {
+        current().pool = this;
+        current().index = index;
+        while(!m_stop)
+        {
+            if(!tryRun(index))
+            {
+                boost::mutex::scoped_lock lock(m_sleep_mutex);
+                while((m_pending == 0) && !m_stop)
+                    m_wake.wait(lock);
+            }
+        }
+    }
+public :
+    /** \brief Start worker_count threads.
+     *
+     * With 0 workers, tasks are run by the threads waiting for them.
+     */
+    explicit ThreadPool(unsigned worker_count)
+        : m_pending(0), m_stop(false)
+    {
+        for(unsigned i = 0; i <= worker_count; ++i)
+        {
+            m_queues.emplace_back(new Queue());
+        }
+        for(unsigned i = 0; i < worker_count; ++i)
+        {
+            m_threads.create_thread([this, i]() { work(i); });
+        }
+    }
+
+    ThreadPool(ThreadPool const &) = delete;
+    ThreadPool & operator=(ThreadPool const &) = delete;
+
+    /** \brief Stop workers, queued tasks are dropped. */
+    ~ThreadPool()
+    {
+        {
+            boost::mutex::scoped_lock lock(m_sleep_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        m_threads.join_all();
+    }
+
+    /** \brief Pool shared by the whole process.
+     *
+     * Created on first use with one worker less than hardware threads,
+     * the caller of TaskGroup::wait is the last one.
+     */
+    static ThreadPool & global()
+    {
+        static ThreadPool pool(std::max(boost::thread::hardware_concurrency(), 1u)-1);
+        return pool;
+    }
+
+    size_t workerCount() const noexcept
+    {
+        return m_queues.size()-1;
+    }
+
+    /** \brief Queue task in the deque of the calling thread. */
+    void push(Task task)
+    {
+        {
+            Queue & q = *m_queues[queueIndex()];
+            boost::mutex::scoped_lock lock(q.mutex);
+            q.tasks.push_back(std::move(task));
+            ++m_pending;
+        }
+        {
+            // sleeping workers check m_pending under this lock
+            boost::mutex::scoped_lock lock(m_sleep_mutex);
+        }
+        m_wake.notify_one();
+    }
+
+    /** \brief Run one queued task in the calling thread.
+     * \returns false if there was none
+     */
+    bool runOne()
+    {
+        return tryRun(queueIndex());
+    }
+};
+
+/** \brief Fork-join group of tasks.
+ *
+ * run queues a task, wait returns when all tasks of the group are finished,
+ * the waiting thread runs queued tasks (its own first) in the meantime.
+ * Tasks can create nested groups.
+ * The first exception thrown by a task is rethrown by wait,
+ * the group is finished anyway, so all tasks run to their end.
+ */
+class TaskGroup
+{
+    ThreadPool & m_pool;
+
+    std::atomic<size_t> m_count;
+
+    boost::mutex m_error_mutex;
+    std::exception_ptr m_error;
+
+    void join()
+    {
+        while(m_count != 0)
+        {
+            if(!m_pool.runOne())
+                boost::this_thread::yield();
+        }
+    }
+public :
+    explicit TaskGroup(ThreadPool & pool = ThreadPool::global())
+        : m_pool(pool), m_count(0)
+    {}
+
+    TaskGroup(TaskGroup const &) = delete;
+    TaskGroup & operator=(TaskGroup const &) = delete;
+
+    /** \brief Wait for tasks, their exceptions are dropped. */
+    ~TaskGroup()
+    {
+        join();
+    }
+
+    template<typename Function>
+    void run(Function f)
+    {
+        ++m_count;
+        m_pool.push([this, f]() mutable
+        {
+            try
+            {
+                f();
+            }
+            catch(...)
+            {
+                boost::mutex::scoped_lock lock(m_error_mutex);
+                if(!m_error)
+                    m_error = std::current_exception();
+            }
+            --m_count;
+        });
+    }
+
+    /** \brief Wait for all tasks.
+     * \throws first exception of the tasks
+     */
+    void wait()
+    {
+        join();
+        std::exception_ptr error;
+        {
+            boost::mutex::scoped_lock lock(m_error_mutex);
+            std::swap(error, m_error);
+        }
+        if(error)
+            std::rethrow_exception(error);
+    }
+};
+
+}//namespace utils
+
+#endif//THREAD_POOL_H_INCLUDED
@@ -1,12 +1,16 @@
 #define BOOST_ENABLE_ASSERT_HANDLER
 
+#include "cct/array_attributes.h"
 #include "cct/array_builder.h"
+#include "cct/array_order.h"
+#include "cct/array_storage.h"
 
 #include "utils/abs_diff.h"
 
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/min.hpp>
@@ -26,6 +30,10 @@ struct arg_int * tile_width = nullptr;
 struct arg_int * tile_height = nullptr;
 struct arg_int * parallel_depth = nullptr;
 struct arg_lit * parallel_nomerge = nullptr;
+struct arg_int * node_order = nullptr;
+struct arg_int * thread_count = nullptr;
+struct arg_int * grid_cols = nullptr;
+struct arg_int * grid_rows = nullptr;
 
 template<typename Alpha, typename WeightFunctor>
 void process(
@@ -41,42 +49,38 @@ void process(
         boost::accumulators::tag::mean
         > > time_statistics;
 
-    size_t const vertex_count = cct::image::vertexCount(image.size());
     //size_t const edge_count = cct::image::edgeCount(image.size());
 
     cv::Size_<uint16_t> const size = image.size();
     cv::Size_<uint16_t> const tile(tile_width->ival[0], tile_height->ival[0]);
 
     size_t component_count;
+    size_t height;
+    size_t root_count;
+
+    // memory is reused for all measurements and images
+    static array_tree_storage<uint32_t, uint32_t, Alpha> storage;
+    static std::vector<uint32_t> lut;
 
     for(int i = 0; i < measurements->ival[0]; ++i)
     {
         auto t1 = boost::chrono::high_resolution_clock::now();
 
-        array_tree<uint32_t, uint32_t, Alpha> t;//(vertex_count);
-        t.leaf_count = vertex_count;
-        t.node_count = vertex_count;
-        t.node_capacity = 2*vertex_count-1;
-        t.invalid_count = 0;
-        t.parents = new uint32_t[t.node_capacity];
-        t.leaf_levels = new Alpha[t.node_capacity];
-        t.comp_levels = t.leaf_levels + t.leaf_count;
-        t.child_count = new uint32_t[(t.node_capacity-t.leaf_count)+3];
-        t.children = new uint32_t[(t.node_capacity-t.leaf_count)*2];
-        t.reset();
-
-        cct::image::buildAlphaTree(size, tile, t, WeightFunctor(image));
-        if(child_list->count)
+        array_tree<uint32_t, uint32_t, Alpha> & t = cct::image::buildAlphaTree(size, tile, storage, WeightFunctor(image));
+        if(child_list->count || node_order->ival[0])
             t.build_children();
+        if(node_order->ival[0])
+        {
+            lut.resize(t.componentCount());
+            cct::reorderTree(t, cct::NodeOrder(node_order->ival[0]), lut.data());
+        }
  
         auto t2 = boost::chrono::high_resolution_clock::now();
 
         component_count = t.componentCount();
-
-        delete [] t.parents;
-        delete [] t.leaf_levels;
-        delete [] t.child_count;
-        delete [] t.children;
+        // O(node_count) stats, outside of the measured time
+        height = cct::computeHeight(t);
+        root_count = cct::countRoots(t);
 
         time_statistics(boost::chrono::duration_cast<boost::chrono::duration<double>>(t2-t1).count());
     }
@@ -85,12 +89,9 @@ void process(
         << id << ',' << filename << ',' << image.cols << ',' << image.rows << ','
         << cct::image::vertexCount(image.size()) << ',' << cct::image::edgeCount(image.size()) << ','
         << component_count << ','
+        << height << ','
+        << root_count << ','
         << 0 << ','
-        << 0 << ','
-        << 0 << ','
-//        << tree.calcHeight() << ','
-//        << tree.rootCount() << ','
-//        << tree.countDegenerateComponents() << ','
         << boost::accumulators::min(time_statistics) << ','
         << boost::accumulators::max(time_statistics) << ','
         << boost::accumulators::mean(time_statistics)
@@ -0,0 +1,81 @@
+#define BOOST_ENABLE_ASSERT_HANDLER
+
+#include "cct/image_tree.h"
+
+#include "utils/abs_diff.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/min.hpp>
+#include <boost/accumulators/statistics/max.hpp>
+#include <boost/accumulators/statistics/mean.hpp>
+#include <boost/chrono.hpp>
+
+#include <argtable2.h>
+
+#include <opencv2/highgui/highgui.hpp>
+
+// Command line arguments
+
+struct arg_lit * child_list = nullptr;
+struct arg_int * measurements = nullptr;
+struct arg_int * tile_width = nullptr;
+struct arg_int * tile_height = nullptr;
+struct arg_int * parallel_depth = nullptr;
+struct arg_lit * parallel_nomerge = nullptr;
+struct arg_int * node_order = nullptr;
+struct arg_int * thread_count = nullptr;
+struct arg_int * grid_cols = nullptr;
+struct arg_int * grid_rows = nullptr;
+
+template<typename Alpha, typename WeightFunctor>
+void process(
+    int id, char const * filename, cv::Mat const & image
+)
+{
+    typedef cct::image::IndexComponent<Alpha> Component;
+    typedef cct::image::IndexLeaf Leaf;
+    typedef cct::Tree<Component, Leaf> Tree;
+    typedef cct::Builder<Tree> Builder;
+
+    cv::Size const size = image.size();
+    cv::Size const tile(tile_width->ival[0], tile_height->ival[0]);
+
+    boost::accumulators::accumulator_set<double, boost::accumulators::features<
+        boost::accumulators::tag::min,
+        boost::accumulators::tag::max,
+        boost::accumulators::tag::mean
+        > > time_statistics;
+
+    Tree tree(cct::image::vertexCount(image.size()));
+    Builder builder(&tree);
+
+    for(int i = 0; i < measurements->ival[0]; ++i)
+    {
+        builder.reset();
+        tree.reset();
+
+        auto t1 = boost::chrono::high_resolution_clock::now();
+        cct::image::buildAlphaTree(size, tile, builder, WeightFunctor(image));
+        auto t2 = boost::chrono::high_resolution_clock::now();
+
+        time_statistics(boost::chrono::duration_cast<boost::chrono::duration<double>>(t2-t1).count());
+    }
+
+    std::cout
+        << id << ',' << filename << ',' << image.cols << ',' << image.rows << ','
+        << cct::image::vertexCount(image.size()) << ',' << cct::image::edgeCount(image.size()) << ','
+        << tree.componentCount() << ','
+        << tree.calculateHeight() << ','
+        << tree.rootCount() << ','
+        << tree.countDegenerateComponents() << ','
+        << boost::accumulators::min(time_statistics) << ','
+        << boost::accumulators::max(time_statistics) << ','
+        << boost::accumulators::mean(time_statistics)
+        << std::endl;
+}        
+
+#include "imgtree.h"
@@ -1,6 +1,8 @@
 #define BOOST_ENABLE_ASSERT_HANDLER
 
 #include "cct/image_tree.h"
+#include "cct/array_bpt.h"
+#include "cct/array_storage.h"
 #include "cct/array_tree.h"
 
 #include "utils/abs_diff.h"
@@ -27,6 +29,10 @@ struct arg_int * tile_width = nullptr;
 struct arg_int * tile_height = nullptr;
 struct arg_int * parallel_depth = nullptr;
 struct arg_lit * parallel_nomerge = nullptr;
+struct arg_int * node_order = nullptr;
+struct arg_int * thread_count = nullptr;
+struct arg_int * grid_cols = nullptr;
+struct arg_int * grid_rows = nullptr;
 
 template<typename Alpha, typename WeightFunctor>
 void process(
@@ -50,30 +56,23 @@ void process(
 
     size_t component_count;
 
+    // memory is reused for all measurements and images
+    static array_tree_storage<uint32_t, uint32_t, Alpha> storage;
+
     for(int i = 0; i < measurements->ival[0]; ++i)
     {
         auto t1 = boost::chrono::high_resolution_clock::now();
 
-        Edge * edges = new Edge[edge_count];
+        Edge * edges = storage.template buffer<Edge>(edge_count);
         getSortedImageEdges(
             cv::Rect_<uint16_t>(0,0,image.cols,image.rows),
             tile, edges, WeightFunctor(image)
         );
 
-        cct::PackedRootFinder<uint32_t, uint32_t> root(vertex_count, cct::LeafIndexTag());
-
-        array_tree<uint32_t, uint32_t, uint8_t> t;//(vertex_count);
-        t.leaf_count = vertex_count;
-        t.node_count = vertex_count;
-        t.node_capacity = 2*vertex_count-1;
-        t.invalid_count = 0;
-        t.parents = new uint32_t[t.node_capacity];
-        t.leaf_levels = new uint8_t[t.node_capacity];
-        t.comp_levels = t.leaf_levels + t.leaf_count;
-        t.children = new uint32_t[(t.node_capacity-t.leaf_count)*2];
-        t.reset();
+        cct::PackedRootFinder<uint32_t, uint32_t> & root = storage.root_finder();
+        root.init(vertex_count, cct::LeafIndexTag());
 
-        uint32_t * merges = new uint32_t[t.leaf_count];
+        array_tree<uint32_t, uint32_t, Alpha> & t = storage.init(vertex_count);
 
         for(uint32_t i = 0; i < edge_count; ++i)
         {
@@ -86,19 +85,16 @@ void process(
                 );
             }
         }
-        t.bpt_postprocess();
-        t.compress(merges);
+        if(parallel_depth->ival[0] > 0)
+            cct::bptPostprocess(t, storage.merges(), 1u << parallel_depth->ival[0]);
+        else
+            t.bpt_postprocess();
+        t.compress(storage.merges());
  
         auto t2 = boost::chrono::high_resolution_clock::now();
 
         component_count = t.componentCount();
 
-        delete [] edges;
-        delete [] t.parents;
-        delete [] t.leaf_levels;
-        delete [] t.children;
-        delete [] merges;
-
         time_statistics(boost::chrono::duration_cast<boost::chrono::duration<double>>(t2-t1).count());
     }
 
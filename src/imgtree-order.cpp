@@ -0,0 +1,97 @@
+#define BOOST_ENABLE_ASSERT_HANDLER
+
+#include "cct/array_attributes.h"
+#include "cct/array_builder.h"
+#include "cct/array_order.h"
+#include "cct/array_storage.h"
+
+#include "utils/abs_diff.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/min.hpp>
+#include <boost/accumulators/statistics/max.hpp>
+#include <boost/accumulators/statistics/mean.hpp>
+#include <boost/chrono.hpp>
+
+#include <argtable2.h>
+
+#include <opencv2/highgui/highgui.hpp>
+
+// Command line arguments
+
+struct arg_lit * child_list = nullptr;
+struct arg_int * measurements = nullptr;
+struct arg_int * tile_width = nullptr;
+struct arg_int * tile_height = nullptr;
+struct arg_int * parallel_depth = nullptr;
+struct arg_lit * parallel_nomerge = nullptr;
+struct arg_int * node_order = nullptr;
+struct arg_int * thread_count = nullptr;
+struct arg_int * grid_cols = nullptr;
+struct arg_int * grid_rows = nullptr;
+
+// Benchmark of attribute passes over array_tree in different node orders.
+// Tree construction is not measured.
+template<typename Alpha, typename WeightFunctor>
+void process(
+    int id,
+    char const * filename, cv::Mat const & image
+)
+{
+    boost::accumulators::accumulator_set<double, boost::accumulators::features<
+        boost::accumulators::tag::min,
+        boost::accumulators::tag::max,
+        boost::accumulators::tag::mean
+        > > time_statistics;
+
+    cv::Size_<uint16_t> const size = image.size();
+    cv::Size_<uint16_t> const tile(tile_width->ival[0], tile_height->ival[0]);
+
+    // memory is reused for all images
+    static array_tree_storage<uint32_t, uint32_t, Alpha> storage;
+
+    array_tree<uint32_t, uint32_t, Alpha> & t = cct::image::buildAlphaTree(size, tile, storage, WeightFunctor(image));
+    t.build_children();
+    std::vector<uint32_t> lut(t.componentCount());
+    cct::reorderTree(t, cct::NodeOrder(node_order->ival[0]), lut.data());
+
+    std::vector<uint32_t> area(t.componentCount());
+    // area spectrum, power of two bins
+    size_t const bin_count = 33;
+    double spectrum[bin_count];
+    auto bin = [](uint32_t, uint32_t a) -> size_t
+        {
+            return 32 - __builtin_clz(a);
+        };
+
+    for(int i = 0; i < measurements->ival[0]; ++i)
+    {
+        auto t1 = boost::chrono::high_resolution_clock::now();
+
+        cct::computeArea(t, area.data());
+        cct::patternSpectrum(t, area.data(), bin, spectrum, bin_count);
+
+        auto t2 = boost::chrono::high_resolution_clock::now();
+
+        time_statistics(boost::chrono::duration_cast<boost::chrono::duration<double>>(t2-t1).count());
+    }
+
+    std::cout
+        << id << ',' << filename << ',' << image.cols << ',' << image.rows << ','
+        << cct::image::vertexCount(image.size()) << ',' << cct::image::edgeCount(image.size()) << ','
+        << t.componentCount() << ','
+        << 0 << ','
+        << 0 << ','
+        << 0 << ','
+        << boost::accumulators::min(time_statistics) << ','
+        << boost::accumulators::max(time_statistics) << ','
+        << boost::accumulators::mean(time_statistics)
+        << std::endl;
+}
+
+#include "imgtree.h"
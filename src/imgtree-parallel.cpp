@@ -4,9 +4,12 @@
 
 #include "utils/abs_diff.h"
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 #include <boost/accumulators/accumulators.hpp>
 #include <boost/accumulators/statistics/min.hpp>
@@ -26,6 +29,61 @@ struct arg_int * tile_width = nullptr;
 struct arg_int * tile_height = nullptr;
 struct arg_int * parallel_depth = nullptr;
 struct arg_lit * parallel_nomerge = nullptr;
+struct arg_int * node_order = nullptr;
+struct arg_int * thread_count = nullptr;
+struct arg_int * grid_cols = nullptr;
+struct arg_int * grid_rows = nullptr;
+
+// --threads N uses a grid of tiles instead of --parallel-depth,
+// workers are shared by all images and pixel types, the main thread is the last one
+utils::ThreadPool & threadPool()
+{
+    static utils::ThreadPool pool(std::max(thread_count->ival[0], 1)-1);
+    return pool;
+}
+
+// Parent of every node, nodes by level and smallest leaf below, leaves by level -1
+template<typename Tree>
+std::vector<std::pair<std::pair<double, size_t>, std::pair<double, size_t>>> treeLinks(Tree const & tree)
+{
+    typedef std::pair<double, size_t> Key;
+    std::vector<std::pair<Key, Key>> links;
+    // children of open components, begin of their children and smallest leaf
+    std::vector<Key> children;
+    std::vector<std::pair<size_t, size_t>> open;
+    tree.forEach(
+        [&](typename Tree::Component const &)
+        {
+            open.push_back(std::make_pair(children.size(), size_t(-1)));
+        },
+        [&](typename Tree::Component const & c)
+        {
+            auto const o = open.back();
+            open.pop_back();
+            Key const key(double(c.level()), o.second);
+            for(size_t i = o.first; i < children.size(); ++i)
+            {
+                links.push_back(std::make_pair(children[i], key));
+            }
+            children.resize(o.first);
+            if(!open.empty())
+                open.back().second = std::min(open.back().second, o.second);
+            children.push_back(key);
+        },
+        [&](typename Tree::Leaf const & l)
+        {
+            size_t const id = tree.leafId(l);
+            children.push_back(Key(-1.0, id));
+            open.back().second = std::min(open.back().second, id);
+        }
+    );
+    for(Key const & root : children)
+    {
+        links.push_back(std::make_pair(root, Key(-1.0, size_t(-1))));
+    }
+    std::sort(links.begin(), links.end());
+    return links;
+}
 
 template<typename Alpha, typename WeightFunctor>
 void process(
@@ -49,13 +107,27 @@ void process(
     Tree tree(cct::image::vertexCount(image.size()));
     Builder builder(&tree);
 
+    utils::ThreadPool & pool = threadPool();
+    unsigned const threads = unsigned(pool.workerCount()+1);
+    // 4 tiles per thread by default
+    int const cols = grid_cols->ival[0] ? grid_cols->ival[0] : 2*std::max(thread_count->ival[0], 1);
+    int const rows = grid_rows->ival[0] ? grid_rows->ival[0] : 2;
+    cv::Size const grid(std::min(cols, size.width), std::min(rows, size.height));
+    std::vector<cct::image::Edge<int, decltype(WeightFunctor(image)(cv::Point(), cv::Point()))>> connectors;
+
     for(int i = 0; i < measurements->ival[0]; ++i)
     {
         builder.reset();
         tree.reset();
 
         auto t1 = boost::chrono::high_resolution_clock::now();
-        cct::image::buildAlphaTree(size, tile, builder, WeightFunctor(image), parallel_depth->ival[0]);
+        // --parallel-nomerge stops at the forest of tile trees
+        if(parallel_nomerge->count)
+            cct::image::buildAlphaTreeNomerge(size, tile, builder, WeightFunctor(image), grid, connectors, pool);
+        else if(thread_count->ival[0] > 0)
+            cct::image::buildAlphaTree(size, tile, builder, WeightFunctor(image), grid, pool);
+        else
+            cct::image::buildAlphaTree(size, tile, builder, WeightFunctor(image), parallel_depth->ival[0]);
         auto t2 = boost::chrono::high_resolution_clock::now();
 
         time_statistics(boost::chrono::duration_cast<boost::chrono::duration<double>>(t2-t1).count());
@@ -65,13 +137,26 @@ void process(
         << id << ',' << filename << ',' << image.cols << ',' << image.rows << ','
         << cct::image::vertexCount(image.size()) << ',' << cct::image::edgeCount(image.size()) << ','
         << tree.componentCount() << ',' << std::flush
-        << tree.calculateHeight() << ','
+        << tree.calculateHeight(threads) << ','
         << tree.rootCount() << ',' << std::flush
-        << tree.countDegenerateComponents() << ','
+        << tree.countDegenerateComponents(threads) << ','
         << boost::accumulators::min(time_statistics) << ','
         << boost::accumulators::max(time_statistics) << ','
         << boost::accumulators::mean(time_statistics)
         << std::endl;
+
+    if(parallel_nomerge->count)
+    {
+        // forest of the last measurement must merge to the tree of the grid mode
+        cct::image::mergeForest(size, builder, connectors);
+        Tree merged(cct::image::vertexCount(image.size()));
+        Builder merged_builder(&merged);
+        cct::image::buildAlphaTree(size, tile, merged_builder, WeightFunctor(image), grid, pool);
+        tree.removeDegenerateComponents();
+        merged.removeDegenerateComponents();
+        if(treeLinks(tree) != treeLinks(merged))
+            std::cerr << "merged forest of " << filename << " differs from the grid build" << std::endl;
+    }
 }        
 
 #include "imgtree.h"
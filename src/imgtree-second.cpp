@@ -0,0 +1,118 @@
+#define BOOST_ENABLE_ASSERT_HANDLER
+
+#include "cct/array_builder.h"
+#include "cct/array_storage.h"
+
+#include "utils/abs_diff.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/min.hpp>
+#include <boost/accumulators/statistics/max.hpp>
+#include <boost/accumulators/statistics/mean.hpp>
+#include <boost/chrono.hpp>
+
+#include <argtable2.h>
+
+#include <opencv2/highgui/highgui.hpp>
+
+// Command line arguments
+
+struct arg_lit * child_list = nullptr;
+struct arg_int * measurements = nullptr;
+struct arg_int * tile_width = nullptr;
+struct arg_int * tile_height = nullptr;
+struct arg_int * parallel_depth = nullptr;
+struct arg_lit * parallel_nomerge = nullptr;
+struct arg_int * node_order = nullptr;
+struct arg_int * thread_count = nullptr;
+struct arg_int * grid_cols = nullptr;
+struct arg_int * grid_rows = nullptr;
+
+// Vertex weight is the minimal weight of incident edges, so edges are never below their vertices
+template<typename WeightFunctor>
+class MinIncidentWeight
+{
+    WeightFunctor m_e;
+    cv::Size m_size;
+public :
+    explicit MinIncidentWeight(cv::Mat const & image)
+        : m_e(image), m_size(image.size())
+    {}
+
+    template<typename T>
+    auto operator()(cv::Point_<T> const & p) const -> decltype(m_e(p, p))
+    {
+        typedef cv::Point_<T> Point;
+        auto w = std::numeric_limits<decltype(m_e(p, p))>::max();
+        if(p.x > 0)
+            w = std::min(w, m_e(p, Point(p.x-1, p.y)));
+        if(p.x+1 < m_size.width)
+            w = std::min(w, m_e(p, Point(p.x+1, p.y)));
+        if(p.y > 0)
+            w = std::min(w, m_e(p, Point(p.x, p.y-1)));
+        if(p.y+1 < m_size.height)
+            w = std::min(w, m_e(p, Point(p.x, p.y+1)));
+        return w;
+    }
+};
+
+template<typename Alpha, typename WeightFunctor>
+void process(
+    int id,
+    char const * filename, cv::Mat const & image
+)
+{
+    boost::accumulators::accumulator_set<double, boost::accumulators::features<
+        boost::accumulators::tag::min,
+        boost::accumulators::tag::max,
+        boost::accumulators::tag::mean
+        > > time_statistics;
+
+    cv::Size_<uint16_t> const size = image.size();
+    cv::Size_<uint16_t> const tile(tile_width->ival[0], tile_height->ival[0]);
+
+    size_t component_count;
+
+    // memory is reused for all measurements and images
+    static array_tree_storage<uint32_t, uint32_t, Alpha> storage;
+
+    for(int i = 0; i < measurements->ival[0]; ++i)
+    {
+        auto t1 = boost::chrono::high_resolution_clock::now();
+
+        array_tree<uint32_t, uint32_t, Alpha> & t = cct::image::buildSecondOrderTree(
+            size, tile, storage,
+            MinIncidentWeight<WeightFunctor>(image), WeightFunctor(image)
+        );
+        if(child_list->count)
+            t.build_children();
+ 
+        auto t2 = boost::chrono::high_resolution_clock::now();
+
+        component_count = t.componentCount();
+
+        time_statistics(boost::chrono::duration_cast<boost::chrono::duration<double>>(t2-t1).count());
+    }
+
+    std::cout
+        << id << ',' << filename << ',' << image.cols << ',' << image.rows << ','
+        << cct::image::vertexCount(image.size()) << ',' << cct::image::edgeCount(image.size()) << ','
+        << component_count << ','
+        << 0 << ','
+        << 0 << ','
+        << 0 << ','
+//        << tree.calcHeight() << ','
+//        << tree.rootCount() << ','
+//        << tree.countDegenerateComponents() << ','
+        << boost::accumulators::min(time_statistics) << ','
+        << boost::accumulators::max(time_statistics) << ','
+        << boost::accumulators::mean(time_statistics)
+        << std::endl;
+}        
+
+#include "imgtree.h"
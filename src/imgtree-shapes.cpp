@@ -0,0 +1,91 @@
+#define BOOST_ENABLE_ASSERT_HANDLER
+
+#include "cct/array_storage.h"
+#include "cct/image_graph.h"
+#include "cct/image_shapes.h"
+
+#include "utils/abs_diff.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include <boost/accumulators/accumulators.hpp>
+#include <boost/accumulators/statistics/min.hpp>
+#include <boost/accumulators/statistics/max.hpp>
+#include <boost/accumulators/statistics/mean.hpp>
+#include <boost/chrono.hpp>
+
+#include <argtable2.h>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// Command line arguments
+
+struct arg_lit * child_list = nullptr;
+struct arg_int * measurements = nullptr;
+struct arg_int * tile_width = nullptr;
+struct arg_int * tile_height = nullptr;
+struct arg_int * parallel_depth = nullptr;
+struct arg_lit * parallel_nomerge = nullptr;
+struct arg_int * node_order = nullptr;
+struct arg_int * thread_count = nullptr;
+struct arg_int * grid_cols = nullptr;
+struct arg_int * grid_rows = nullptr;
+
+template<typename Alpha, typename WeightFunctor>
+void process(
+    int id,
+    char const * filename, cv::Mat const & image
+)
+{
+    boost::accumulators::accumulator_set<double, boost::accumulators::features<
+        boost::accumulators::tag::min,
+        boost::accumulators::tag::max,
+        boost::accumulators::tag::mean
+        > > time_statistics;
+
+    // tree of shapes is defined for gray images only
+    cv::Mat gray = image;
+    if(image.type() != CV_8UC1)
+        cv::cvtColor(image, gray, CV_BGR2GRAY);
+
+    size_t component_count;
+
+    // memory is reused for all measurements and images
+    static array_tree_storage<uint32_t, uint32_t, uint8_t> storage;
+
+    for(int i = 0; i < measurements->ival[0]; ++i)
+    {
+        auto t1 = boost::chrono::high_resolution_clock::now();
+
+        array_tree<uint32_t, uint32_t, uint8_t> & t = storage.init(gray.cols*gray.rows);
+        cct::image::buildTreeOfShapes(gray, t);
+        if(child_list->count)
+            t.build_children();
+ 
+        auto t2 = boost::chrono::high_resolution_clock::now();
+
+        component_count = t.componentCount();
+
+        time_statistics(boost::chrono::duration_cast<boost::chrono::duration<double>>(t2-t1).count());
+    }
+
+    std::cout
+        << id << ',' << filename << ',' << image.cols << ',' << image.rows << ','
+        << cct::image::vertexCount(image.size()) << ',' << cct::image::edgeCount(image.size()) << ','
+        << component_count << ','
+        << 0 << ','
+        << 0 << ','
+        << 0 << ','
+//        << tree.calcHeight() << ','
+//        << tree.rootCount() << ','
+//        << tree.countDegenerateComponents() << ','
+        << boost::accumulators::min(time_statistics) << ','
+        << boost::accumulators::max(time_statistics) << ','
+        << boost::accumulators::mean(time_statistics)
+        << std::endl;
+}        
+
+#include "imgtree.h"
@@ -26,6 +26,10 @@ struct arg_int * tile_width = nullptr;
 struct arg_int * tile_height = nullptr;
 struct arg_int * parallel_depth = nullptr;
 struct arg_lit * parallel_nomerge = nullptr;
+struct arg_int * node_order = nullptr;
+struct arg_int * thread_count = nullptr;
+struct arg_int * grid_cols = nullptr;
+struct arg_int * grid_rows = nullptr;
 
 template<typename Alpha, typename WeightFunctor>
 void process(
@@ -60,6 +60,10 @@ int main(int argc, char * argv[])
         tile_height  = arg_int0(NULL, "tile-height", "", NULL),
         parallel_depth   = arg_int0("d", "parallel-depth", "", NULL),
         parallel_nomerge = arg_lit0(NULL, "parallel-nomerge", NULL),
+        node_order = arg_int0(NULL, "node-order", "", NULL),
+        thread_count = arg_int0("t", "threads", "", NULL),
+        grid_cols = arg_int0(NULL, "grid-cols", "", NULL),
+        grid_rows = arg_int0(NULL, "grid-rows", "", NULL),
         outname,
         input_files = arg_filen(NULL, NULL, "<image>", 1, argc-1, NULL),
         end };
@@ -70,6 +74,10 @@ int main(int argc, char * argv[])
     parallel_depth->ival[0] = 0;
     tile_width->ival[0] = 64;
     tile_height->ival[0] = 16;
+    node_order->ival[0] = 0;
+    thread_count->ival[0] = 0;
+    grid_cols->ival[0] = 0;
+    grid_rows->ival[0] = 0;
 
     int error_count = arg_parse(argc, argv, argtable);
 
@@ -89,6 +97,17 @@ int main(int argc, char * argv[])
         return EXIT_FAILURE;
     }
 
+    if((thread_count->ival[0] < 0) || (grid_cols->ival[0] < 0) || (grid_rows->ival[0] < 0))
+    {
+        std::cerr << "--threads, --grid-cols and --grid-rows can't be negative" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if((node_order->ival[0] < 0) || (node_order->ival[0] > 2))
+    {
+        std::cerr << "--node-order must be 0 (merge), 1 (depth first) or 2 (breadth first)" << std::endl;
+        return EXIT_FAILURE;
+    }
+
     int retval = EXIT_FAILURE;
 
     switch(edge_norm->ival[0])